@@ -1,5 +1,19 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/decompress.h"
+#include "huffman/dictionary.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/options.h"
+#include "huffman/seekable.h"
+#include "huffman/state.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 /*!
  *	\file dehuf.c
@@ -12,180 +26,227 @@
  */
 
 /*!
- *	\def fail(x, rf)
- *	Si un caractère extrait à l'aide getc correspond à EOF et que ferror(rf) est vrai, putc a recontré une erreur.\n
- *	Il y'a donc un affichage de message d'erreur suite à la lecture et le programme se termine.
- */
-#define fail(x, rf)                                                                                                    \
-	if (x == EOF && ferror(rf))                                                                                    \
-	{                                                                                                              \
-		fprintf(stderr, "\nErreur : Lecture du fichier (getc).\n\n");                                          \
-		fclose(rf);                                                                                            \
-		exit(EXIT_FAILURE);                                                                                    \
-	}
-/*!
- *	\struct node
- *	\brief Représentation d'un noeud dans l'arbre.
+ *	\fn bool writeAll(void *, const uint8_t *, size_t)
+ *	\param opaque Pointeur sur le descripteur du fichier de sortie.
+ *	\param data Caractères décodés.
+ *	\param size Nombre de caractères.
+ *	\return true si tout a été écrit.
  *
- *	Un noeud est composé d'une valeur, une frequence, un fils gauche / droit et un pere.
- *	Si il est une feuille, les fils gauche et droit seront mis à -1.
+ *	Les caractères sont écrits avec write(), sans passer par stdio : la bibliothèque les passe par tranches de
+ *HUFFMAN_OUTPUT_BUFFER_SIZE octets.
  */
-struct node
+bool writeAll(void *opaque, const uint8_t *data, size_t size)
 {
-	unsigned char c;         /*!<Valeur du noeud.*/
-	unsigned int freq;       /*!<Fréquence du noeud.*/
-	int left, right, parent; /*!<Fils gauche, droit et parent.*/
-};
-
-struct node arrayN[2 * 256 - 1]; /*!< \brief Tableau de noeuds de taille 2 * 256 - 1.*/
-int arrayL[256];                 /*!< \brief Tableau de feuilles de taille 256. */
-int root = 256;                  /*!< \brief Position de la racine dans arrayN. */
-unsigned int nleafs = 0;         /*!< \brief Nombre de feuilles. */
-unsigned int sizeFile = 0;       /*!< \brief Nombre de caractères dans le fichier. */
+	int fd = *(const int *)opaque;
+	while (size > 0)
+	{
+		ssize_t n = write(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n, size -= n;
+	}
+	return true;
+}
 
 /*!
- *	\fn unsigned int read(FILE *)
+ *	\fn int uncompress(FILE *, int, const huffman_options_t *)
  *	\param rf Fichier sur lequel nous allons lire.
- *	\return Un unsigned int.
- *	On récupère 4 octets et que l'on replace dans un unsigned int avec des décalages de 24, 16, 8, 0 et un | unaire.
+ *	\param fd Descripteur du fichier décompressé (la sortie standard par défaut).
+ *	\param options Nombre de threads pour décoder les blocs en parallèle, et dictionnaire éventuel.
+ *	\return 0 si la décompression a réussi, 1 sinon.
+ *
+ *	Cette fonction décompresse le fichier (ancien format ou format par blocs) et l'écrit dans fd par grandes
+ *tranches.\n
+ *	Le décodage est fait par huffman_decompress_sink() : l'arbre est reconstruit à partir de l'entête, puis
+ *transformé en table de décodage pour lire plusieurs bits à la fois au lieu de parcourir l'arbre bit par bit.
  */
-unsigned int read(FILE *rf)
+int uncompress(FILE *rf, int fd, const huffman_options_t *options)
 {
-	int x, y, z, t;
-	x = getc(rf);
-	fail(x, rf);
-	y = getc(rf);
-	fail(y, rf);
-	z = getc(rf);
-	fail(z, rf);
-	t = getc(rf);
-	fail(t, rf);
-	return (x << 24 | y << 16 | z << 8 | t);
+	huffman_state_t *state = huffman_state_new();
+	if (!state)
+	{
+		fprintf(stderr, "\nErreur : Allocation mémoire dynamique.\n\n");
+		return 1;
+	}
+	int result = huffman_decompress_sink(state, options, rf, writeAll, &fd) ? 0 : 1;
+	if (result != 0)
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+	free(state);
+	return result;
 }
+
 /*!
- *	\fn int buildTree(int *, int, int*, int)
- *	\param STACK Un tableau d'entier (qui sera un tableau provenant de la lecture de l'arbre en entête du fichier
- *compressé). \param size Taille du tableau STACK. \param i Position dans le tableau STACK. \param node Position dans
- *arrayN lors de la reconstruction. \return La position d'un noeud à l'aide de STACK si elle est inférieure sinon -1.
+ *	\fn int verify(FILE *, const huffman_options_t *)
+ *	\param rf Fichier à vérifier.
+ *	\param options Nombre de threads et dictionnaire éventuel, comme pour la décompression.
+ *	\return 0 si le fichier est intact, 1 sinon.
  *
- *	Cette fonction reconstruit l'arbre récursivement à partir de l'entête.
+ *	Avec -k 1, le fichier est décodé sans rien écrire : huffman_decompress_verify() compare le CRC-32C des caractères
+ *de chaque bloc et de toute la trame aux sommes de contrôle du fichier (format par blocs depuis la version 10).\n
+ *	L'ancien format (huf -f 1) et les versions précédentes du format par blocs n'ont pas de somme de contrôle : leur
+ *décodage est seulement vérifié jusqu'au bout, une corruption des caractères n'est pas détectée. Un avertissement le
+ *signale.
  */
-int buildTree(int *stack, int size, int *i, int node)
+int verify(FILE *rf, const huffman_options_t *options)
 {
-	if (*i < size)
+	huffman_state_t *state = huffman_state_new();
+	if (!state)
 	{
-		if (stack[*i] < 256)
-		{
-			return stack[*i];
-		}
-		else
-		{
-			node = *i;
-			*i += 1;
-			arrayN[stack[node]].left = buildTree(stack, size, i, node);
-			*i += 1;
-			arrayN[stack[node]].right = buildTree(stack, size, i, node);
-			return stack[node];
-		}
+		fprintf(stderr, "\nErreur : Allocation mémoire dynamique.\n\n");
+		return 1;
 	}
-	return -1;
+	int result = huffman_decompress_verify(state, options, rf) ? 0 : 1;
+	if (result != 0)
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+	else if (state->version < HUFFMAN_FORMAT_VERSION_CHECKSUM)
+		fprintf(stderr, "%" PRIu64 " caractères décodés, non vérifiés : pas de somme de contrôle dans ce format.\n",
+		        state->file_size);
+	else
+		fprintf(stderr, "%" PRIu64 " caractères vérifiés.\n", state->file_size);
+	free(state);
+	return result;
 }
+
 /*!
- *	\fn uncompress(FILE *)
- *	\param rf Fichier sur lequel nous allons lire.
+ *	\fn int readRange(FILE *, int, const huffman_options_t *, uint64_t, uint64_t)
+ *	\param rf Fichier compressé avec huf -i 1.
+ *	\param fd Descripteur du fichier où écrire la plage.
+ *	\param options Dictionnaire éventuel.
+ *	\param offset Position du premier caractère à lire.
+ *	\param size Nombre de caractères à lire.
+ *	\return 0 si la plage a été écrite, 1 sinon.
  *
- *	Cette fonction décompresse le fichier et envoie tout sur la sortie standard.\n
- *	On fait une lecture de l'en-tête pour reconstruire l'arbre.\n
- *	Puis on parcours l'arbre en fonction de chaque bit provenant du fichier jusqu'à arriver à une feuille pour
- *l'afficher.
+ *	L'index à la fin du fichier donne la position de chaque bloc : seuls les blocs de la plage sont lus et décodés.
  */
-void uncompress(FILE *rf)
+int readRange(FILE *rf, int fd, const huffman_options_t *options, uint64_t offset, uint64_t size)
 {
-	int c, elem, shift, node, count;
-	int STACK[2 * 256 - 1];
-
-	for (c = 0; c < 256; c++)
-	{
-		arrayN[c].freq = 0, arrayN[c].c = c;
-		arrayN[c].right = -1, arrayN[c].left = -1, arrayN[c].parent = -1;
-	}
-
-	sizeFile = read(rf);
-	nleafs = getc(rf) + getc(rf);
-	count = 0;
-	while (count < nleafs)
+	uint8_t buffer[1 << 16];
+	huffman_seekable_t *seekable = huffman_seekable_open(options, rf, 0);
+	if (!seekable)
 	{
-		arrayL[count++] = getc(rf);
-		fail(arrayL[count - 1], rf);
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+		return 1;
 	}
-	count = 0, shift = 7, node = 0, c = getc(rf);
-	fail(c, rf);
-	while (count < nleafs)
+	int result = 0;
+	while (size > 0 && result == 0)
 	{
-		if (shift < 0)
-		{
-			shift = 7;
-			c = getc(rf);
-			fail(c, rf);
-		}
-		if (c >> shift & 1)
+		size_t n = size < sizeof(buffer) ? size : sizeof(buffer);
+		huffman_status_t status = huffman_seekable_pread(seekable, buffer, n, offset, &n);
+		if (status != kHuffmanOk)
 		{
-			STACK[node] = arrayL[count];
-			count++;
+			fprintf(stderr, "\nErreur : Bloc invalide à la position %" PRIu64 " : %s\n\n", offset, huffman_error());
+			result = 1;
 		}
-		else
+		else if (n == 0)
+			break;
+		else if (!writeAll(&fd, buffer, n))
 		{
-			STACK[node] = 256 + nleafs - 2 - node + count;
+			fprintf(stderr, "\nErreur : Lors de l'écriture.\n\n");
+			result = 1;
 		}
-		node++, shift--;
+		offset += n, size -= n;
 	}
-	root = 256 + nleafs - 2;
-	count = 0;
-	if (STACK[0] < 256)
-		root = arrayL[0];
-	else
-		buildTree(STACK, node, &count, 0);
-	shift = -1;
-	while (sizeFile > 0)
+	huffman_seekable_close(seekable);
+	return result;
+}
+
+/*!
+ *	\fn huffman_dictionary_t *loadDictionary(const char *)
+ *	\param path Fichier écrit par hufdict.
+ *	\return Le dictionnaire, dont la table de décodage est construite une fois pour tous les blocs, ou NULL.
+ */
+huffman_dictionary_t *loadDictionary(const char *path)
+{
+	FILE *rf = fopen(path, "rb");
+	if (!rf)
 	{
-		node = root;
-		while (node >= 256)
-		{
-			if (shift < 0)
-			{
-				shift = 7;
-				elem = getc(rf);
-				fail(elem, rf);
-			}
-			c = elem >> shift;
-			c &= 1;
-			if (c == 1)
-				node = arrayN[node].right;
-			else
-				node = arrayN[node].left;
-			shift--;
-		}
-		printf("%c", arrayN[node].c);
-		sizeFile--;
+		fprintf(stderr, "\n Fichier %s inexistant.\n\n", path);
+		return NULL;
+	}
+	huffman_dictionary_t *dictionary = huffman_dictionary_new();
+	if (!dictionary || !huffman_dictionary_load(dictionary, rf))
+	{
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+		free(dictionary);
+		dictionary = NULL;
 	}
+	fclose(rf);
+	return dictionary;
 }
 
 int main(int argc, char **argv)
 {
-	if (argc != 2)
+	huffman_options_t options;
+	huffman_dictionary_t *dictionary = NULL;
+	const char *range = NULL;
+	bool check = false;
+
+	huffman_options_init(&options);
+	for (; argc > 2 && argv[1][0] == '-' && argv[1][1] != '\0'; argc -= 2, argv += 2)
 	{
-		fprintf(stderr, "\nFormat : %s [input]\n\n", argv[0]);
+		if (strcmp(argv[1], "-t") == 0)
+			options.threads = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-d") == 0 && !dictionary)
+		{
+			if (!(dictionary = loadDictionary(argv[2])))
+				return 1;
+			options.dictionary = dictionary;
+		}
+		else if (strcmp(argv[1], "-r") == 0)
+			range = argv[2];
+		else if (strcmp(argv[1], "-k") == 0)
+			check = strtoul(argv[2], NULL, 0) != 0;
+		else
+			break;
+	}
+	if (argc != 2 && argc != 3)
+	{
+		fprintf(stderr,
+		        "\nFormat : %s [-t threads] [-d dictionnaire] [-r début:taille] [-k 0|1] [input] [output]\n\n",
+		        argv[0]);
 		return 1;
 	}
 
-	FILE *rf = fopen(argv[1], "r");
+	FILE *rf = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
 	if (!rf)
 	{
 		fprintf(stderr, "\n Fichier %s inexistant.\n\n", argv[1]);
 		return 1;
 	}
+	if (check)
+	{
+		int result = verify(rf, &options);
+		fclose(rf);
+		free(dictionary);
+		return result;
+	}
+	int fd = STDOUT_FILENO;
+	if (argc == 3 && strcmp(argv[2], "-") != 0 && (fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+	{
+		fprintf(stderr, "\nErreur : Impossible de créer le fichier %s.\n\n", argv[2]);
+		fclose(rf);
+		return 1;
+	}
 
-	uncompress(rf);
+	int result;
+	if (range)
+	{
+		char *end;
+		uint64_t offset = strtoull(range, &end, 0);
+		result = *end == ':' ? readRange(rf, fd, &options, offset, strtoull(end + 1, NULL, 0)) : 1;
+		if (*end != ':')
+			fprintf(stderr, "\nErreur : Plage invalide (%s).\n\n", range);
+	}
+	else
+		result = uncompress(rf, fd, &options);
+	if (fd != STDOUT_FILENO && close(fd) != 0 && result == 0)
+	{
+		fprintf(stderr, "\nErreur : Lors de l'écriture.\n\n");
+		result = 1;
+	}
 	fclose(rf);
-	return 0;
+	free(dictionary);
+	return result;
 }
@@ -0,0 +1,143 @@
+#include "huffman/archive.h"
+#include "huffman/error.h"
+#include "huffman/options.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*!
+ *	\file hufar.c
+ *	\brief Archiveur HUFFMAN
+ *
+ *	Archive un ou plusieurs répertoires en un seul fichier : chaque fichier est compressé par la bibliothèque en une
+ *trame indépendante, plusieurs fichiers à la fois, et un index central donne le nom, la position, la taille et le
+ *CRC-32C de chaque membre. Un membre s'extrait seul, sans décompresser les autres. Remplace archiveur.py, qui lançait
+ *huf une fois par fichier puis recompressait le tout dans un .tar.gz.
+ */
+
+/*!
+ *	\fn int list(const huffman_archive_t *)
+ *	\param archive Archive ouverte.
+ *	\return 0.
+ *
+ *	Affiche la taille, la taille compressée et le nom de chaque membre.
+ */
+int list(const huffman_archive_t *archive)
+{
+	for (uint64_t i = 0; i < archive->count; i++)
+	{
+		const huffman_archive_entry_t *entry = &archive->entries[i];
+		printf("%12" PRIu64 " %12" PRIu64 "  %s\n", entry->size, entry->length, entry->name);
+	}
+	return 0;
+}
+
+/*!
+ *	\fn int print(const huffman_archive_t *, const char *, const huffman_options_t *)
+ *	\param archive Archive ouverte.
+ *	\param name Nom du membre.
+ *	\param options Options de décompression.
+ *	\return 0 si le membre a été écrit sur la sortie standard, 1 sinon.
+ */
+int print(const huffman_archive_t *archive, const char *name, const huffman_options_t *options)
+{
+	const huffman_archive_entry_t *entry = huffman_archive_find(archive, name);
+	if (!entry)
+	{
+		fprintf(stderr, "\nErreur : Membre %s introuvable.\n\n", name);
+		return 1;
+	}
+	if (!huffman_archive_extract(archive, entry, options, stdout))
+	{
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ *	\fn int extract(const huffman_archive_t *, const char *, const huffman_options_t *)
+ *	\param archive Archive ouverte.
+ *	\param directory Répertoire où extraire les membres.
+ *	\param options Options de décompression.
+ *	\return 0 si tous les membres ont été extraits, 1 sinon.
+ */
+int extract(const huffman_archive_t *archive, const char *directory, const huffman_options_t *options)
+{
+	if (!huffman_archive_extract_all(archive, options, directory))
+	{
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	huffman_options_t options;
+	const char *program = argv[0];
+
+	huffman_options_init(&options);
+	for (; argc > 3 && argv[1][0] == '-'; argc -= 2, argv += 2)
+	{
+		if (strcmp(argv[1], "-b") == 0)
+			options.block_size = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-t") == 0)
+			options.threads = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-l") == 0)
+			options.max_code_length = strtoul(argv[2], NULL, 0);
+		else
+			break;
+	}
+	if (argc < 3 || strlen(argv[1]) != 1 || !strchr("clxp", argv[1][0]) || (argv[1][0] == 'c' && argc < 4) ||
+	    (argv[1][0] == 'l' && argc != 3) || (argv[1][0] == 'x' && argc > 4) || (argv[1][0] == 'p' && argc != 4))
+	{
+		fprintf(stderr,
+		        "\nFormat : %s [-b taille] [-t threads] [-l longueur] c [archive] [chemins...]\n"
+		        "         %s l [archive]\n"
+		        "         %s [-t threads] x [archive] [répertoire]\n"
+		        "         %s p [archive] [membre]\n\n",
+		        program, program, program, program);
+		return 1;
+	}
+
+	if (argv[1][0] == 'c')
+	{
+		FILE *wf = fopen(argv[2], "wb");
+		if (!wf)
+		{
+			fprintf(stderr, "\nErreur : Impossible de créer le fichier %s.\n\n", argv[2]);
+			return 1;
+		}
+		bool ok = huffman_archive_create(&options, argv + 3, argc - 3, wf);
+		if (!ok)
+			fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+		if (fclose(wf) != 0 && ok)
+		{
+			fprintf(stderr, "\nErreur : Lors de l'écriture (fwrite).\n\n");
+			ok = false;
+		}
+		return ok ? 0 : 1;
+	}
+
+	FILE *rf = fopen(argv[2], "rb");
+	if (!rf)
+	{
+		fprintf(stderr, "\nErreur :  Fichier %s introuvable.\n\n", argv[2]);
+		return 1;
+	}
+	huffman_archive_t *archive = huffman_archive_open(rf);
+	int result = 1;
+	if (!archive)
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+	else if (argv[1][0] == 'l')
+		result = list(archive);
+	else if (argv[1][0] == 'x')
+		result = extract(archive, argc == 4 ? argv[3] : ".", &options);
+	else
+		result = print(archive, argv[3], &options);
+	huffman_archive_close(archive);
+	fclose(rf);
+	return result;
+}
@@ -0,0 +1,449 @@
+#define _XOPEN_SOURCE 700
+
+#include "huffman/block.h"
+#include "huffman/build.h"
+#include "huffman/code.h"
+#include "huffman/compress.h"
+#include "huffman/decompress.h"
+#include "huffman/histogram.h"
+#include "huffman/options.h"
+#include "huffman/state.h"
+#include "huffman/writer.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*!
+ *	\file hufbench.c
+ *	\brief Mesure des performances HUFFMAN
+ *
+ *	Programme qui compresse puis décompresse un corpus généré (aléatoire uniforme, loi de Zipf, texte, un seul
+ *caractère, les 256 caractères, texte et Zipf mêlés) pour des tailles de 1 Ko à la taille maximale demandée. Chaque
+ *étape est mesurée séparément : histogramme, construction du codage (et durée d'une construction d'arbre), encodage
+ *et décodage, puis la compression et la décompression complètes. Les résultats sont écrits en CSV ou en JSON pour
+ *comparer deux versions.
+ */
+
+typedef enum
+{
+	kCorpusUniform,
+	kCorpusZipf,
+	kCorpusText,
+	kCorpusSingle,
+	kCorpusAll,
+	kCorpusMixed,
+	kCorpusCount,
+} corpus_t;
+
+static const char *const corpus_names[kCorpusCount] = {"uniform", "zipf", "text", "single", "all256",
+                                                               "mixed"};
+
+typedef struct bench
+{
+	huffman_options_t options;
+	double min_time;  /*!< \brief Durée minimale de mesure de chaque étape, en secondes. */
+	bool json;
+	FILE *output;
+} bench_t;
+
+/*!
+ *	\brief Une mesure : un corpus d'une taille donnée, compressé et décompressé.
+ */
+typedef struct bench_case
+{
+	const bench_t *bench;
+	uint8_t *data;
+	size_t size;
+	uint8_t *compressed;
+	size_t compressed_size;
+	size_t capacity;
+	uint8_t *decompressed;
+	huffman_state_t state;
+	huffman_block_t block;
+} bench_case_t;
+
+typedef double (*stage_t)(bench_case_t *bcase);
+
+static uint64_t next_random(uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+	return *seed;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*!
+ *	\fn void generate(corpus_t, uint8_t *, size_t)
+ *	\brief Remplit data de façon reproductible : la même graine donne le même corpus d'une version à l'autre.
+ */
+void generate(corpus_t corpus, uint8_t *data, size_t size)
+{
+	static const char *const words[] = {"le", "de", "un", "et", "la", "les", "des", "en", "du", "une", "que",
+	                                    "est", "pour", "qui", "dans", "par", "plus", "pas", "au", "sur", "fichier",
+	                                    "arbre", "codage", "caractère", "compression", "huffman", "bloc", "table"};
+	double cumulative[CHAR_COUNT];
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	double sum = 0;
+
+	switch (corpus)
+	{
+	case kCorpusUniform:
+		for (size_t i = 0; i < size; i++)
+			data[i] = next_random(&seed) >> 56;
+		break;
+	case kCorpusZipf:
+		for (uint16_t r = 0; r < CHAR_COUNT; r++)
+			cumulative[r] = (sum += 1.0 / (r + 1));
+		for (size_t i = 0; i < size; i++)
+		{
+			double x = (next_random(&seed) >> 11) * 0x1p-53 * sum;
+			uint16_t r = 0;
+			while (r < CHAR_COUNT - 1 && cumulative[r] < x)
+				r++;
+			data[i] = r;
+		}
+		break;
+	case kCorpusText:
+		for (size_t i = 0; i < size;)
+		{
+			uint64_t x = next_random(&seed);
+			/* Le minimum de deux tirages favorise les premiers mots, comme dans une vraie langue. */
+			size_t a = x % (sizeof(words) / sizeof(*words));
+			size_t b = (x >> 32) % (sizeof(words) / sizeof(*words));
+			const char *word = words[a < b ? a : b];
+			for (; *word != '\0' && i < size; word++)
+				data[i++] = *word;
+			if (i < size)
+				data[i++] = (x >> 24) % 12 == 0 ? '\n' : ' ';
+		}
+		break;
+	case kCorpusSingle:
+		memset(data, 'a', size);
+		break;
+	case kCorpusMixed:
+		/* Tranches de 16 Ko à 256 Ko, tour à tour texte et Zipf : une archive de fichiers texte et binaires. */
+		for (size_t i = 0, n, k = 0; i < size; i += n, k++)
+		{
+			n = ((size_t)16 << 10) << ((next_random(&seed) >> 32) % 5);
+			n = n < size - i ? n : size - i;
+			generate(k % 2 == 0 ? kCorpusText : kCorpusZipf, data + i, n);
+		}
+		break;
+	default:
+		for (size_t i = 0; i < size; i++)
+			data[i] = i + i / CHAR_COUNT;
+		break;
+	}
+}
+
+static double stage_histogram(bench_case_t *bcase)
+{
+	size_t block_size = bcase->bench->options.block_size;
+	double start = now();
+	for (size_t i = 0; i < bcase->size; i += block_size)
+	{
+		uint64_t count[CHAR_COUNT] = {0};
+		huffman_histogram(count, bcase->data + i, bcase->size - i < block_size ? bcase->size - i : block_size);
+	}
+	return now() - start;
+}
+
+/*!
+ *	\brief Construction de l'arbre et des codages de chaque bloc, à partir de son histogramme calculé hors mesure.
+ */
+static double stage_build(bench_case_t *bcase)
+{
+	const huffman_options_t *options = &bcase->bench->options;
+	huffman_code_t code[CHAR_COUNT];
+	uint8_t length[CHAR_COUNT];
+	double elapsed = 0;
+
+	for (size_t i = 0; i < bcase->size; i += options->block_size)
+	{
+		uint64_t count[CHAR_COUNT] = {0};
+		huffman_histogram(count, bcase->data + i,
+		                  bcase->size - i < options->block_size ? bcase->size - i : options->block_size);
+		double start = now();
+		huffman_state_init(&bcase->state);
+		huffman_set_frequencies(&bcase->state, count);
+		if (huffman_build(&bcase->state))
+		{
+			if (options->max_code_length != 0)
+			{
+				huffman_code_lengths(length, &bcase->state, options->max_code_length);
+				huffman_canonical_code(code, length);
+			}
+			else
+			{
+				huffman_calculate_code(code, &bcase->state.tree);
+			}
+		}
+		elapsed += now() - start;
+	}
+	return elapsed;
+}
+
+/*!
+ *	\fn double measure_tree(bench_case_t *)
+ *	\return La durée moyenne d'une construction d'arbre, en nanosecondes.
+ *
+ *	Seuls huffman_set_frequencies() et huffman_build() sont mesurés, sur l'histogramme du premier bloc : c'est un
+ *coût fixe payé par chaque bloc, quelle que soit sa taille.
+ */
+double measure_tree(bench_case_t *bcase)
+{
+	const huffman_options_t *options = &bcase->bench->options;
+	uint64_t count[CHAR_COUNT] = {0};
+	uint64_t trees = 0;
+	double start = now();
+	double elapsed;
+
+	huffman_histogram(count, bcase->data, bcase->size < options->block_size ? bcase->size : options->block_size);
+	do
+	{
+		for (int i = 0; i < 1000; i++)
+		{
+			huffman_set_frequencies(&bcase->state, count);
+			huffman_build(&bcase->state);
+		}
+		trees += 1000;
+		elapsed = now() - start;
+	} while (elapsed < bcase->bench->min_time);
+	return elapsed / trees * 1e9;
+}
+
+/*!
+ *	\brief Écriture des caractères codés de chaque bloc, préparé hors mesure.
+ */
+static double stage_encode(bench_case_t *bcase)
+{
+	const huffman_options_t *options = &bcase->bench->options;
+	huffman_writer_t writer;
+	double elapsed = 0;
+
+	huffman_writer_init(&writer, bcase->compressed, bcase->capacity, NULL);
+	for (size_t i = 0; i < bcase->size; i += options->block_size)
+	{
+		size_t size = bcase->size - i < options->block_size ? bcase->size - i : options->block_size;
+		huffman_block_prepare(&bcase->state, &bcase->block, bcase->data + i, size, options, NULL);
+		double start = now();
+		huffman_block_write(&bcase->state, &bcase->block, &writer, bcase->data + i);
+		elapsed += now() - start;
+	}
+	return elapsed;
+}
+
+static double stage_compress(bench_case_t *bcase)
+{
+	double start = now();
+	huffman_compress_buffer(&bcase->bench->options, bcase->data, bcase->size, bcase->compressed, bcase->capacity,
+	                        &bcase->compressed_size);
+	return now() - start;
+}
+
+static double stage_decompress(bench_case_t *bcase)
+{
+	size_t size;
+	double start = now();
+	huffman_decompress_buffer(&bcase->bench->options, bcase->compressed, bcase->compressed_size,
+	                          bcase->decompressed, bcase->size, &size);
+	return now() - start;
+}
+
+/*!
+ *	\fn double measure(bench_case_t *, stage_t)
+ *	\return Le débit de l'étape en Mo/s de caractères non compressés.
+ *
+ *	L'étape est répétée jusqu'à durer au moins bench->min_time secondes, pour que les petites tailles restent
+ *mesurables.
+ */
+double measure(bench_case_t *bcase, stage_t stage)
+{
+	double start = now();
+	double elapsed = 0;
+	uint64_t bytes = 0;
+
+	do
+	{
+		elapsed += stage(bcase);
+		bytes += bcase->size;
+	} while (now() - start < bcase->bench->min_time);
+	return elapsed > 0 ? bytes / elapsed / 1e6 : 0;
+}
+
+/*!
+ *	\fn int run_case(const bench_t *, corpus_t, size_t, bool)
+ *	\return 0 si la mesure a réussi, 1 sinon.
+ *
+ *	Exécuté dans un processus fils : le pic de mémoire résidente ne compte que cette mesure.
+ */
+int run_case(const bench_t *bench, corpus_t corpus, size_t size, bool first)
+{
+	bench_case_t *bcase = calloc(1, sizeof(bench_case_t));
+	if (!bcase)
+		return 1;
+	bcase->bench = bench;
+	bcase->size = size;
+	bcase->capacity = huffman_compress_bound(&bench->options, size);
+	bcase->data = malloc(size);
+	bcase->compressed = malloc(bcase->capacity);
+	bcase->decompressed = malloc(size);
+	if (!bcase->data || !bcase->compressed || !bcase->decompressed)
+	{
+		fprintf(stderr, "\nErreur : Allocation mémoire dynamique (%s, %zu octets).\n\n", corpus_names[corpus],
+		        size);
+		return 1;
+	}
+	generate(corpus, bcase->data, size);
+
+	double histogram = measure(bcase, stage_histogram);
+	double build = measure(bcase, stage_build);
+	double tree = measure_tree(bcase);
+	double encode = measure(bcase, stage_encode);
+	double compress = measure(bcase, stage_compress);
+	double decode = measure(bcase, stage_decompress);
+	size_t size_out;
+	if (huffman_decompress_buffer(&bench->options, bcase->compressed, bcase->compressed_size, bcase->decompressed,
+	                              size, &size_out) != kHuffmanOk ||
+	    size_out != size || memcmp(bcase->data, bcase->decompressed, size) != 0)
+	{
+		fprintf(stderr, "\nErreur : Décompression incorrecte (%s, %zu octets).\n\n", corpus_names[corpus],
+		        size);
+		return 1;
+	}
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	double ratio = (double)bcase->compressed_size / size;
+
+	const huffman_options_t *options = &bench->options;
+	if (bench->json)
+		fprintf(bench->output,
+		        "%s  {\"corpus\": \"%s\", \"size\": %zu, \"block_size\": %zu, \"threads\": %u, "
+		        "\"streams\": %u, \"contexts\": %u, \"split\": %u, \"compressed\": %zu, \"ratio\": %.4f, "
+		        "\"histogram_mbs\": %.1f, \"build_mbs\": %.1f, \"tree_ns\": %.0f, \"encode_mbs\": %.1f, "
+		        "\"compress_mbs\": %.1f, \"decode_mbs\": %.1f, \"peak_rss_kb\": %ld}",
+		        first ? "" : ",\n", corpus_names[corpus], size, options->block_size, options->threads,
+		        options->streams, options->contexts, options->split, bcase->compressed_size, ratio, histogram,
+		        build, tree, encode, compress, decode, usage.ru_maxrss);
+	else
+		fprintf(bench->output, "%s,%zu,%zu,%u,%u,%u,%u,%zu,%.4f,%.1f,%.1f,%.0f,%.1f,%.1f,%.1f,%ld\n",
+		        corpus_names[corpus], size, options->block_size, options->threads, options->streams,
+		        options->contexts, options->split, bcase->compressed_size, ratio, histogram, build, tree,
+		        encode, compress, decode, usage.ru_maxrss);
+	fflush(bench->output);
+	return 0;
+}
+
+static size_t parse_size(const char *text)
+{
+	char *end;
+	size_t size = strtoull(text, &end, 0);
+	switch (*end)
+	{
+	case 'G':
+		size <<= 10;
+		/* fall through */
+	case 'M':
+		size <<= 10;
+		/* fall through */
+	case 'K':
+		size <<= 10;
+		break;
+	}
+	return size;
+}
+
+int main(int argc, char **argv)
+{
+	bench_t bench = {.min_time = 0.2, .json = false, .output = stdout};
+	size_t max_size = 64 << 20;
+	int result = 0;
+
+	huffman_options_init(&bench.options);
+	for (; argc > 2 && argv[1][0] == '-'; argc -= 2, argv += 2)
+	{
+		if (strcmp(argv[1], "-s") == 0)
+			max_size = parse_size(argv[2]);
+		else if (strcmp(argv[1], "-b") == 0)
+			bench.options.block_size = parse_size(argv[2]);
+		else if (strcmp(argv[1], "-t") == 0)
+			bench.options.threads = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-l") == 0)
+			bench.options.max_code_length = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-n") == 0)
+			bench.options.streams = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-c") == 0)
+			bench.options.contexts = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-a") == 0)
+			bench.options.split = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-m") == 0)
+			bench.min_time = strtod(argv[2], NULL);
+		else if (strcmp(argv[1], "-f") == 0)
+			bench.json = strcmp(argv[2], "json") == 0;
+		else if (strcmp(argv[1], "-o") == 0)
+		{
+			if (!(bench.output = fopen(argv[2], "w")))
+			{
+				fprintf(stderr, "\nErreur : Impossible de créer le fichier %s.\n\n", argv[2]);
+				return 1;
+			}
+		}
+		else
+			break;
+	}
+	if (argc != 1 || !huffman_options_check(&bench.options))
+	{
+		fprintf(stderr, "\nFormat : %s [-s taille max] [-b taille] [-t threads] [-l longueur] [-n flux] "
+		                "[-c tables] [-a niveau] [-m secondes] [-f csv|json] [-o fichier]\n\n",
+		        argv[0]);
+		return 1;
+	}
+
+	if (bench.json)
+		fprintf(bench.output, "[\n");
+	else
+		fprintf(bench.output, "corpus,size,block_size,threads,streams,contexts,split,compressed,ratio,"
+		                      "histogram_mbs,build_mbs,tree_ns,encode_mbs,compress_mbs,decode_mbs,"
+		                      "peak_rss_kb\n");
+	/* De 1 Ko à max_size, en multipliant par 16. */
+	size_t sizes[32];
+	int count = 0;
+	for (size_t size = 1 << 10; size < max_size && count < 31; size *= 16)
+		sizes[count++] = size;
+	sizes[count++] = max_size;
+
+	bool first = true;
+	for (int corpus = 0; corpus < kCorpusCount; corpus++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			fflush(bench.output);
+			pid_t pid = fork();
+			if (pid == 0)
+				_exit(run_case(&bench, corpus, sizes[i], first));
+			int status;
+			if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				result = 1;
+			else
+				first = false;
+		}
+	}
+	if (bench.json)
+		fprintf(bench.output, "\n]\n");
+	if (bench.output != stdout)
+		fclose(bench.output);
+	return result;
+}
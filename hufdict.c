@@ -0,0 +1,87 @@
+#include "huffman/dictionary.h"
+#include "huffman/error.h"
+#include "huffman/histogram.h"
+#include "huffman/limits.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*!
+ *	\file hufdict.c
+ *	\brief Apprentissage d'un dictionnaire HUFFMAN
+ *
+ *	Programme qui construit un codage à partir de fichiers d'exemple, pour compresser de petits messages sans écrire
+ *leur arbre.
+ */
+
+/*!
+ *	\fn int train(FILE *, uint32_t, unsigned, char **, int)
+ *	\param wf Fichier du dictionnaire.
+ *	\param id Identifiant écrit dans chaque bloc compressé avec le dictionnaire.
+ *	\param max_length Longueur maximale d'un codage.
+ *	\param samples Fichiers d'exemple.
+ *	\param count Nombre de fichiers d'exemple.
+ *	\return 0 si le dictionnaire a été écrit, 1 sinon.
+ *
+ *	Les fréquences de tous les exemples sont additionnées, puis huffman_dictionary_train() construit l'arbre et le
+ *codage canonique du dictionnaire.
+ */
+int train(FILE *wf, uint32_t id, unsigned max_length, char **samples, int count)
+{
+	uint64_t frequencies[CHAR_COUNT] = {0};
+	uint8_t buffer[1 << 16];
+	size_t size;
+
+	for (int i = 0; i < count; i++)
+	{
+		FILE *rf = fopen(samples[i], "rb");
+		if (!rf)
+		{
+			fprintf(stderr, "\nErreur :  Fichier %s introuvable.\n\n", samples[i]);
+			return 1;
+		}
+		while ((size = fread(buffer, 1, sizeof(buffer), rf)) > 0)
+			huffman_histogram(frequencies, buffer, size);
+		fclose(rf);
+	}
+
+	huffman_dictionary_t *dictionary = huffman_dictionary_new();
+	bool ok = dictionary && huffman_dictionary_train(dictionary, id, frequencies, max_length) &&
+	          huffman_dictionary_save(dictionary, wf);
+	if (!ok)
+		fprintf(stderr, "\nErreur : %s\n\n", huffman_error());
+	free(dictionary);
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t id = 1;
+	unsigned max_length = HUFFMAN_CODE_LENGTH_MAX;
+
+	for (; argc > 3 && argv[1][0] == '-' && argv[1][1] != '\0'; argc -= 2, argv += 2)
+	{
+		if (strcmp(argv[1], "-i") == 0)
+			id = strtoul(argv[2], NULL, 0);
+		else if (strcmp(argv[1], "-l") == 0)
+			max_length = strtoul(argv[2], NULL, 0);
+		else
+			break;
+	}
+	if (argc < 3 || max_length < HUFFMAN_CODE_LENGTH_MIN || max_length > HUFFMAN_CODE_LENGTH_MAX)
+	{
+		fprintf(stderr, "\nFormat : %s [-i identifiant] [-l longueur] [dictionnaire] [exemples...]\n\n",
+		        argv[0]);
+		return 1;
+	}
+	FILE *wf = fopen(argv[1], "wb");
+	if (!wf)
+	{
+		fprintf(stderr, "\nErreur : Impossible de créer le fichier %s.\n\n", argv[1]);
+		return 1;
+	}
+	int result = train(wf, id, max_length, argv + 2, argc - 2);
+	fclose(wf);
+	return result;
+}
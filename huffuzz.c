@@ -0,0 +1,410 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/compress.h"
+#include "huffman/decompress.h"
+#include "huffman/options.h"
+#include "huffman/seekable.h"
+#include "huffman/status.h"
+#include "huffman/stream.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*!
+ *	\file huffuzz.c
+ *	\brief Cible de fuzzing du décodeur HUFFMAN
+ *
+ *	Chaque entrée est décodée comme un fichier compressé reçu d'un tiers : d'un seul tenant en mémoire, avec un et
+ *deux threads, par morceaux avec le décodeur incrémental, et par plages avec l'index d'un fichier seekable. Une entrée
+ *invalide doit être refusée par un code d'erreur ; si plusieurs décodages réussissent, ils doivent donner les mêmes
+ *caractères, sinon le programme s'arrête avec abort().\n
+ *	Compilée avec -DHUFFMAN_LIBFUZZER, la cible fournit seulement LLVMFuzzerTestOneInput() pour libFuzzer, sinon un
+ *main() la lance sur chaque fichier donné en paramètre, ou sur l'entrée standard (afl-fuzz, reproduction d'un cas).
+ *huffuzz -s répertoire y écrit le corpus initial.
+ */
+
+/*
+ * Taille des tampons de sortie : un entête peut annoncer jusqu'à 4 Go de caractères, le décodage s'arrête alors sur
+ * kHuffmanErrorSize une fois le tampon plein.
+ */
+#define FUZZ_OUTPUT_SIZE (1 << 22)
+
+static uint8_t expected[FUZZ_OUTPUT_SIZE];
+static uint8_t output[FUZZ_OUTPUT_SIZE];
+
+/*!
+ *	\fn void check(bool, const char *)
+ *	\param condition Propriété que le décodage doit respecter.
+ *	\param what Description de la propriété.
+ *
+ *	Arrête le programme avec abort() pour que le fuzzer garde l'entrée.
+ */
+static void check(bool condition, const char *what)
+{
+	if (condition)
+		return;
+	fprintf(stderr, "\nErreur : %s.\n\n", what);
+	abort();
+}
+
+/*!
+ *	\fn huffman_status_t decodeBuffer(const uint8_t *, size_t, unsigned, uint8_t *, size_t *)
+ *	\param data Entrée à décoder.
+ *	\param size Taille de l'entrée.
+ *	\param threads Nombre de threads du décodage.
+ *	\param dst Tampon de FUZZ_OUTPUT_SIZE octets.
+ *	\param dst_size Nombre de caractères décodés.
+ *	\return Le code d'erreur de huffman_decompress_buffer().
+ */
+static huffman_status_t decodeBuffer(const uint8_t *data, size_t size, unsigned threads, uint8_t *dst,
+                                     size_t *dst_size)
+{
+	huffman_options_t options;
+
+	huffman_options_init(&options);
+	options.threads = threads;
+	huffman_status_t status = huffman_decompress_buffer(&options, data, size, dst, FUZZ_OUTPUT_SIZE, dst_size);
+	check(status == kHuffmanOk || *dst_size == 0, "Caractères rendus malgré une erreur");
+	return status;
+}
+
+/*!
+ *	\fn huffman_status_t decodeStream(const uint8_t *, size_t, size_t, uint8_t *, size_t *)
+ *	\param data Entrée à décoder.
+ *	\param size Taille de l'entrée.
+ *	\param chunk Nombre d'octets donnés à chaque appel de huffman_stream_feed().
+ *	\param dst Tampon de FUZZ_OUTPUT_SIZE octets.
+ *	\param dst_size Nombre de caractères décodés.
+ *	\return kHuffmanOk si la trame est complète, le code d'erreur du flux sinon.
+ */
+static huffman_status_t decodeStream(const uint8_t *data, size_t size, size_t chunk, uint8_t *dst, size_t *dst_size)
+{
+	huffman_stream_t *stream = huffman_stream_new(NULL);
+	huffman_status_t status = kHuffmanOk;
+	size_t pos = 0;
+
+	*dst_size = 0;
+	if (stream == NULL)
+		return kHuffmanErrorMemory;
+	while (status == kHuffmanOk && !huffman_stream_finished(stream))
+	{
+		size_t n = size - pos < chunk ? size - pos : chunk;
+		size_t consumed;
+		size_t read;
+		status = huffman_stream_feed(stream, data + pos, n, &consumed);
+		check(consumed <= n, "Le flux consomme plus que reçu");
+		pos += consumed;
+		while (status == kHuffmanOk && *dst_size < FUZZ_OUTPUT_SIZE)
+		{
+			status = huffman_stream_read(stream, dst + *dst_size, FUZZ_OUTPUT_SIZE - *dst_size, &read);
+			if (read == 0)
+				break;
+			*dst_size += read;
+		}
+		/* Sans octet consommé, l'entrée est épuisée avant la fin de la trame. */
+		if (status == kHuffmanOk && *dst_size == FUZZ_OUTPUT_SIZE)
+			status = kHuffmanErrorSize;
+		else if (status == kHuffmanOk && consumed == 0 && !huffman_stream_finished(stream))
+			status = kHuffmanErrorData;
+	}
+	huffman_stream_free(stream);
+	return status;
+}
+
+/*!
+ *	\fn bool decodeSeekable(const uint8_t *, size_t, uint8_t *, size_t *)
+ *	\param data Entrée à décoder.
+ *	\param size Taille de l'entrée.
+ *	\param dst Tampon de FUZZ_OUTPUT_SIZE octets.
+ *	\param dst_size Nombre de caractères décodés.
+ *	\return true si l'entrée a un index valide et que toutes les plages ont été décodées.
+ *
+ *	L'index est lu avec pread() : l'entrée est d'abord copiée dans un fichier temporaire. Les plages sont lues à
+ *l'envers, pour que chaque bloc soit chargé sans ses voisins.
+ */
+static bool decodeSeekable(const uint8_t *data, size_t size, uint8_t *dst, size_t *dst_size)
+{
+	*dst_size = 0;
+	FILE *rf = tmpfile();
+	if (rf == NULL)
+		return false;
+	if (fwrite(data, 1, size, rf) != size || fflush(rf) != 0)
+	{
+		fclose(rf);
+		return false;
+	}
+	huffman_seekable_t *seekable = huffman_seekable_open(NULL, rf, 0);
+	bool ok = seekable != NULL && seekable->size <= FUZZ_OUTPUT_SIZE;
+	if (ok)
+	{
+		size_t total = seekable->size;
+		size_t step = total / 3 + 1;
+		for (size_t end = total; ok && end > 0; end = end > step ? end - step : 0)
+		{
+			size_t start = end > step ? end - step : 0;
+			size_t n;
+			ok = huffman_seekable_pread(seekable, dst + start, end - start, start, &n) == kHuffmanOk &&
+			     n == end - start;
+		}
+		*dst_size = ok ? total : 0;
+	}
+	huffman_seekable_close(seekable);
+	fclose(rf);
+	return ok;
+}
+
+/*!
+ *	\fn int LLVMFuzzerTestOneInput(const uint8_t *, size_t)
+ *	\param data Entrée générée par le fuzzer.
+ *	\param size Taille de l'entrée.
+ *	\return 0 (l'entrée est toujours gardée dans le corpus si elle est utile).
+ *
+ *	Le décodage d'un seul tenant sert de référence : les autres décodages qui réussissent doivent lui être
+ *identiques. Le décodeur incrémental reçoit l'entrée par morceaux d'une taille tirée de son dernier octet.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	size_t expected_size;
+	size_t output_size;
+
+	huffman_status_t status = decodeBuffer(data, size, 1, expected, &expected_size);
+	if (decodeBuffer(data, size, 2, output, &output_size) == kHuffmanOk)
+	{
+		check(status == kHuffmanOk, "Trame acceptée seulement avec plusieurs threads");
+		check(output_size == expected_size && memcmp(output, expected, output_size) == 0,
+		      "Décodages parallèle et séquentiel différents");
+	}
+	size_t chunk = size > 0 ? 1 + data[size - 1] % 64 : 1;
+	if (decodeStream(data, size, chunk, output, &output_size) == kHuffmanOk && status == kHuffmanOk)
+		check(output_size == expected_size && memcmp(output, expected, output_size) == 0,
+		      "Décodages incrémental et d'un seul tenant différents");
+	if (decodeSeekable(data, size, output, &output_size) && status == kHuffmanOk)
+		check(output_size == expected_size && memcmp(output, expected, output_size) == 0,
+		      "Décodage par plages différent");
+	return 0;
+}
+
+#ifndef HUFFMAN_LIBFUZZER
+/*
+ * Nombre de caractères les plus rares, codés sur 19 bits, répétés au milieu de l'entrée de deepTree().
+ */
+#define FUZZ_DEEP_RUN 100
+
+static uint8_t source[FUZZ_OUTPUT_SIZE];
+
+/*!
+ *	\fn uint32_t nextRandom(uint32_t *)
+ *	\param state État du générateur (xorshift), non nul.
+ *	\return Le nombre suivant : le corpus est le même sur toutes les plateformes.
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/*!
+ *	\fn size_t textSample(uint8_t *)
+ *	\param data Tampon de FUZZ_OUTPUT_SIZE octets.
+ *	\return Nombre de caractères écrits : 64 Ko de mots tirés d'un petit vocabulaire.
+ */
+static size_t textSample(uint8_t *data)
+{
+	static const char *const words[] = {"le ", "codage ", "de ", "huffman ", "bloc ", "arbre ", "flux ", "\n"};
+	uint32_t state = 1;
+	size_t size = 0;
+
+	while (size < (1 << 16) - 16)
+	{
+		const char *word = words[nextRandom(&state) % (sizeof(words) / sizeof(words[0]))];
+		memcpy(data + size, word, strlen(word));
+		size += strlen(word);
+	}
+	return size;
+}
+
+/*!
+ *	\fn size_t deepTree(uint8_t *)
+ *	\param data Tampon de FUZZ_OUTPUT_SIZE octets.
+ *	\return Nombre de caractères écrits (885 500).
+ *
+ *	Vingt caractères de poids suivant la suite de Fibonacci, multipliés par 50 : l'arbre a deux feuilles à la
+ *profondeur 19, soit la table principale et une sous-table entières. Leurs 100 occurrences se suivent au milieu de
+ *l'entrée, le reste est mélangé : un bloc entrelacé décode alors plusieurs de ces codages à la suite dans chaque flux.
+ */
+static size_t deepTree(uint8_t *data)
+{
+	uint32_t weight[20] = {1, 1};
+	uint32_t state = 1;
+	size_t size = 0;
+
+	for (uint8_t c = 2; c < 20; c++)
+	{
+		weight[c] = weight[c - 1] + weight[c - 2];
+		for (uint32_t i = 0; i < 50 * weight[c]; i++)
+			data[size++] = 'A' + c;
+	}
+	for (size_t i = size - 1; i > 0; i--)
+	{
+		size_t j = nextRandom(&state) % (i + 1);
+		uint8_t c = data[i];
+		data[i] = data[j];
+		data[j] = c;
+	}
+	size_t middle = size / 2;
+	memmove(data + middle + FUZZ_DEEP_RUN, data + middle, size - middle);
+	for (size_t i = 0; i < FUZZ_DEEP_RUN; i++)
+		data[middle + i] = 'A' + i % 2;
+	return size + FUZZ_DEEP_RUN;
+}
+
+/*!
+ *	\fn int writeSeed(const char *, const char *, const huffman_options_t *, const uint8_t *, size_t)
+ *	\param directory Répertoire du corpus.
+ *	\param name Nom du fichier.
+ *	\param options Options de la compression.
+ *	\param data Caractères à compresser.
+ *	\param size Nombre de caractères.
+ *	\return 0 si la trame a été écrite, 1 sinon.
+ *
+ *	La trame est passée à LLVMFuzzerTestOneInput(), puis son décodage doit redonner data : une graine mal décodée
+ *arrête le programme avec abort().
+ */
+static int writeSeed(const char *directory, const char *name, const huffman_options_t *options,
+                     const uint8_t *data, size_t size)
+{
+	char path[4096];
+	size_t capacity = huffman_compress_bound(options, size);
+	size_t compressed_size;
+	size_t output_size;
+	uint8_t *compressed = malloc(capacity);
+
+	if (!compressed ||
+	    huffman_compress_buffer(options, data, size, compressed, capacity, &compressed_size) != kHuffmanOk)
+	{
+		fprintf(stderr, "\nErreur : Compression de la graine %s.\n\n", name);
+		free(compressed);
+		return 1;
+	}
+	LLVMFuzzerTestOneInput(compressed, compressed_size);
+	check(decodeBuffer(compressed, compressed_size, 1, output, &output_size) == kHuffmanOk &&
+	          output_size == size && memcmp(output, data, size) == 0,
+	      "Graine mal décodée");
+	snprintf(path, sizeof(path), "%s/%s", directory, name);
+	FILE *wf = fopen(path, "wb");
+	bool ok = wf && fwrite(compressed, 1, compressed_size, wf) == compressed_size;
+	if (wf && fclose(wf) != 0)
+		ok = false;
+	if (!ok)
+		fprintf(stderr, "\nErreur : Impossible de créer le fichier %s.\n\n", path);
+	free(compressed);
+	return ok ? 0 : 1;
+}
+
+/*!
+ *	\fn int writeSeeds(const char *)
+ *	\param directory Répertoire du corpus, créé s'il n'existe pas.
+ *	\return 0 si toutes les graines ont été écrites, 1 sinon.
+ *
+ *	Une trame par variante du format : options par défaut, flux entrelacés, tables de contextes, index de blocs,
+ *et arbre complet entrelacé dont des codages atteignent la profondeur des sous-tables (deepTree()).
+ */
+static int writeSeeds(const char *directory)
+{
+	huffman_options_t options;
+	int result = 0;
+
+	if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+	{
+		fprintf(stderr, "\nErreur : Impossible de créer le répertoire %s.\n\n", directory);
+		return 1;
+	}
+	size_t size = textSample(source);
+	huffman_options_init(&options);
+	result |= writeSeed(directory, "text", &options, source, size);
+	options.streams = 4;
+	result |= writeSeed(directory, "text-streams", &options, source, size);
+	huffman_options_init(&options);
+	options.contexts = 4;
+	result |= writeSeed(directory, "text-contexts", &options, source, size);
+	huffman_options_init(&options);
+	options.seekable = true;
+	options.block_size = 1 << 14;
+	result |= writeSeed(directory, "text-seekable", &options, source, size);
+
+	size = deepTree(source);
+	huffman_options_init(&options);
+	options.max_code_length = 0;
+	options.block_size = 1 << 20;
+	options.streams = 2;
+	result |= writeSeed(directory, "deep-tree-streams", &options, source, size);
+	return result;
+}
+
+/*!
+ *	\fn int run(FILE *)
+ *	\param rf Fichier à décoder.
+ *	\return 0 si le fichier a été lu, 1 sinon.
+ */
+static int run(FILE *rf)
+{
+	size_t capacity = 1 << 16;
+	size_t size = 0;
+	uint8_t *data = malloc(capacity);
+	while (data != NULL)
+	{
+		size += fread(data + size, 1, capacity - size, rf);
+		if (size < capacity)
+			break;
+		uint8_t *grown = realloc(data, capacity *= 2);
+		if (grown == NULL)
+			free(data);
+		data = grown;
+	}
+	if (data == NULL || ferror(rf))
+	{
+		fprintf(stderr, "\nErreur : Lecture de l'entrée.\n\n");
+		free(data);
+		return 1;
+	}
+	LLVMFuzzerTestOneInput(data, size);
+	free(data);
+	return 0;
+}
+
+/*!
+ *	\fn int main(int, char **)
+ *	\param argc Nombre de paramètres.
+ *	\param argv Fichiers à décoder ; l'entrée standard s'il n'y en a pas. Avec -s répertoire, écrit le corpus
+ *initial.
+ *	\return 0 si toutes les entrées ont été lues.
+ */
+int main(int argc, char **argv)
+{
+	int result = 0;
+
+	if (argc < 2)
+		return run(stdin);
+	if (argc == 3 && strcmp(argv[1], "-s") == 0)
+		return writeSeeds(argv[2]);
+	for (int i = 1; i < argc; i++)
+	{
+		FILE *rf = fopen(argv[i], "rb");
+		if (rf == NULL)
+		{
+			fprintf(stderr, "\nErreur : Impossible d'ouvrir %s.\n\n", argv[i]);
+			result = 1;
+			continue;
+		}
+		result |= run(rf);
+		fclose(rf);
+	}
+	return result;
+}
+#endif
@@ -0,0 +1,21 @@
+#ifndef HUFFMAN_ALLOCATOR_H_
+#define HUFFMAN_ALLOCATOR_H_
+
+#include <stddef.h>
+
+/*
+ * Allocateur fourni par l'appelant (par exemple une arène). free peut être NULL si la mémoire est libérée en bloc
+ * par l'appelant.
+ */
+typedef struct huffman_allocator
+{
+	void *(*alloc)(void *opaque, size_t size);
+	void (*free)(void *opaque, void *data);
+	void *opaque; /*!< \brief Passé tel quel à alloc et free. */
+} huffman_allocator_t;
+
+void *huffman_alloc(const huffman_allocator_t *allocator, size_t size);
+void *huffman_calloc(const huffman_allocator_t *allocator, size_t count, size_t size);
+void huffman_free(const huffman_allocator_t *allocator, void *data);
+
+#endif
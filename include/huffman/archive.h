@@ -0,0 +1,48 @@
+#ifndef HUFFMAN_ARCHIVE_H_
+#define HUFFMAN_ARCHIVE_H_
+
+#include "huffman/options.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Archive : HUFFMAN_ARCHIVE_MAGIC et la version sur 1 octet, puis chaque fichier compressé en une trame du format par
+ * blocs, indépendante des autres. L'index central suit les trames : pour chaque membre, la taille de son nom sur
+ * 2 octets, le nom, la position et la taille de sa trame et sa taille décompressée sur 8 octets chacune, et le
+ * CRC-32C de son contenu sur 4 octets. L'archive se termine par la position de l'index et le nombre de membres sur
+ * 8 octets chacun, puis à nouveau HUFFMAN_ARCHIVE_MAGIC : l'index se lit à partir de la fin, sans parcourir les trames.
+ */
+#define HUFFMAN_ARCHIVE_MAGIC "HUFA"
+#define HUFFMAN_ARCHIVE_VERSION 1
+#define HUFFMAN_ARCHIVE_HEADER_SIZE (4 + 1)
+#define HUFFMAN_ARCHIVE_TRAILER_SIZE (8 + 8 + 4)
+#define HUFFMAN_ARCHIVE_NAME_MAX 0xffff
+
+typedef struct huffman_archive_entry
+{
+	char *name;        /*!< \brief Chemin relatif du fichier, séparé par des '/'. */
+	uint64_t offset;   /*!< \brief Position de la trame dans l'archive. */
+	uint64_t length;   /*!< \brief Taille de la trame. */
+	uint64_t size;     /*!< \brief Taille du fichier. */
+	uint32_t checksum; /*!< \brief CRC-32C du fichier. */
+} huffman_archive_entry_t;
+
+typedef struct huffman_archive
+{
+	FILE *rfd;                        /*!< \brief Archive, lue avec pread() : les membres sont lus en parallèle. */
+	huffman_archive_entry_t *entries; /*!< \brief Index central, dans l'ordre de l'archive. */
+	uint64_t count;                   /*!< \brief Nombre de membres. */
+} huffman_archive_t;
+
+bool huffman_archive_create(const huffman_options_t *options, char *const *paths, size_t count, FILE *wfd);
+huffman_archive_t *huffman_archive_open(FILE *rfd);
+const huffman_archive_entry_t *huffman_archive_find(const huffman_archive_t *archive, const char *name);
+bool huffman_archive_extract(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                             const huffman_options_t *options, FILE *wfd);
+bool huffman_archive_extract_all(const huffman_archive_t *archive, const huffman_options_t *options,
+                                 const char *directory);
+void huffman_archive_close(huffman_archive_t *archive);
+
+#endif
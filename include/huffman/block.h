@@ -0,0 +1,97 @@
+#ifndef HUFFMAN_BLOCK_H_
+#define HUFFMAN_BLOCK_H_
+
+#include "huffman/code.h"
+#include "huffman/decode.h"
+#include "huffman/dictionary.h"
+#include "huffman/model.h"
+#include "huffman/options.h"
+#include "huffman/reader.h"
+#include "huffman/state.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Type (1 octet), nombre de caractères (4 octets) et taille du reste du bloc (4 octets).
+ */
+#define HUFFMAN_BLOCK_HEADER_SIZE 9
+/*
+ * Taille maximale de l'entête d'arbre : nombre de feuilles, feuilles et forme de l'arbre.
+ */
+#define HUFFMAN_BLOCK_TREE_SIZE_MAX (2 + CHAR_COUNT + (2 * CHAR_COUNT) / 8)
+/*
+ * Bit du type d'un bloc dont les caractères sont répartis entre plusieurs flux. Sa table des flux (leur nombre sur
+ * 1 octet puis la taille de chacun sur 4 octets) suit l'entête de codage, et chaque flux est complété jusqu'à l'octet.
+ */
+#define HUFFMAN_BLOCK_INTERLEAVED 0x80
+#define HUFFMAN_BLOCK_STREAMS_SIZE_MAX (1 + 5 * HUFFMAN_STREAMS_MAX)
+/*
+ * Bit du type d'un bloc terminé par le CRC-32C de ses caractères sur 4 octets, compté dans la taille du reste du bloc.
+ */
+#define HUFFMAN_BLOCK_CHECKSUM 0x40
+#define HUFFMAN_BLOCK_CHECKSUM_SIZE 4
+/*
+ * Nombre minimal de caractères par flux : un bloc plus court n'est pas entrelacé.
+ */
+#define HUFFMAN_STREAM_SIZE_MIN 64
+/*
+ * Taille maximale du reste d'un bloc de size caractères : entête d'arbre, table des flux, au plus 64 bits par
+ * caractère et somme de contrôle.
+ */
+#define HUFFMAN_BLOCK_LENGTH_MAX(size)                                                                                 \
+	(HUFFMAN_BLOCK_TREE_SIZE_MAX + HUFFMAN_BLOCK_STREAMS_SIZE_MAX + (uint64_t)(size) * 8 +                         \
+	 HUFFMAN_BLOCK_CHECKSUM_SIZE)
+
+typedef struct huffman_block
+{
+	huffman_code_t code[CHAR_COUNT]; /*!< \brief Codage de chaque caractère (longueur 0 s'il est absent). */
+	uint8_t type;                    /*!< \brief Un huffman_block_type_t. */
+	uint32_t size;                   /*!< \brief Nombre de caractères du bloc. */
+	uint32_t length;                 /*!< \brief Taille du bloc compressé après son entête. */
+	uint64_t bits;                   /*!< \brief Nombre de bits des caractères codés. */
+	uint32_t dictionary;             /*!< \brief Identifiant du dictionnaire d'un bloc kHuffmanBlockDictionary. */
+	uint8_t streams;                 /*!< \brief Nombre de flux (0 : bloc entrelacé dont la table est à lire). */
+	bool has_checksum;               /*!< \brief Le bloc se termine par checksum (HUFFMAN_BLOCK_CHECKSUM). */
+	uint32_t checksum;               /*!< \brief CRC-32C des caractères du bloc (compression). */
+	/*! \brief Taille de chaque flux d'un bloc entrelacé. */
+	uint32_t stream_sizes[HUFFMAN_STREAMS_MAX];
+	/*! \brief Modèle d'ordre 1 essayé avec options.contexts, ou NULL (compression). */
+	huffman_model_t *model;
+} huffman_block_t;
+
+/*
+ * Suivi d'une trame : ses totaux, le CRC-32C de ses caractères, et le dernier codage canonique que les blocs
+ * kHuffmanBlockRepeat réutilisent.
+ */
+typedef struct huffman_frame
+{
+	uint64_t total;               /*!< \brief Nombre de caractères des blocs déjà traités. */
+	uint64_t blocks;              /*!< \brief Nombre de blocs déjà traités. */
+	uint32_t checksum;            /*!< \brief CRC-32C des caractères de ces blocs. */
+	bool has_code;                /*!< \brief lengths contient un codage réutilisable. */
+	uint8_t lengths[CHAR_COUNT];  /*!< \brief Longueur du codage canonique de chaque caractère. */
+	uint32_t size;                /*!< \brief Nombre de caractères du dernier bloc codé avec lengths. */
+	uint64_t bits;                /*!< \brief Nombre de bits de ces caractères. */
+	uint64_t coded;               /*!< \brief Nombre de bits de tous les caractères codés de la trame. */
+} huffman_frame_t;
+
+void huffman_frame_init(huffman_frame_t *frame);
+bool huffman_block_prepare(huffman_state_t *state, huffman_block_t *block, const uint8_t *data, size_t size,
+                           const huffman_options_t *options, const huffman_frame_t *frame);
+void huffman_block_write(const huffman_state_t *state, const huffman_block_t *block, huffman_writer_t *writer,
+                         const uint8_t *data);
+bool huffman_block_read_header(huffman_reader_t *reader, huffman_block_t *block, uint32_t block_size);
+void huffman_block_commit(huffman_frame_t *frame, const huffman_block_t *block);
+const huffman_dictionary_t *huffman_block_read_dictionary(huffman_reader_t *reader,
+                                                          const huffman_dictionary_t *dictionary,
+                                                          huffman_frame_t *frame);
+bool huffman_block_read_code(huffman_reader_t *reader, const huffman_block_t *block, huffman_state_t *state,
+                             huffman_frame_t *frame);
+bool huffman_block_check(huffman_reader_t *reader, const huffman_block_t *block, uint32_t checksum,
+                         huffman_frame_t *frame);
+bool huffman_block_read_streams(huffman_reader_t *reader, const huffman_block_t *block, huffman_streams_t *streams,
+                                uint8_t *scratch);
+
+#endif
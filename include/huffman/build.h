@@ -2,8 +2,11 @@
 #define HUFFMAN_BUILD_H_
 
 #include "huffman/state.h"
+#include "huffman/limits.h"
 #include <stdbool.h>
+#include <stdint.h>
 
+void huffman_set_frequencies(huffman_state_t *state, const uint64_t count[CHAR_COUNT]);
 bool huffman_build(huffman_state_t *state);
 
 #endif
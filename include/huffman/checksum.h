@@ -0,0 +1,16 @@
+#ifndef HUFFMAN_CHECKSUM_H_
+#define HUFFMAN_CHECKSUM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Nombre de caractères comptés ou décodés entre deux mises à jour du CRC-32C, quand il ne peut pas être calculé dans la
+ * même boucle : ils sont encore dans le cache lorsque le CRC les relit.
+ */
+#define HUFFMAN_CHECKSUM_CHUNK (1 << 16)
+
+uint32_t huffman_crc32c(uint32_t crc, const uint8_t *data, size_t size);
+uint32_t huffman_crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+#endif
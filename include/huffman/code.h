@@ -0,0 +1,20 @@
+#ifndef HUFFMAN_CODE_H_
+#define HUFFMAN_CODE_H_
+
+#include "huffman/limits.h"
+#include "huffman/state.h"
+#include "huffman/tree.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct huffman_code
+{
+	uint64_t bits;  /*!< \brief Codage, aligné sur le bit de poids faible. */
+	uint8_t length; /*!< \brief Nombre de bits du codage. */
+} huffman_code_t;
+
+bool huffman_calculate_code(huffman_code_t code[CHAR_COUNT], const huffman_tree_t *tree);
+void huffman_code_lengths(uint8_t length[CHAR_COUNT], const huffman_state_t *state, uint8_t max_length);
+void huffman_canonical_code(huffman_code_t code[CHAR_COUNT], const uint8_t length[CHAR_COUNT]);
+
+#endif
@@ -1,9 +1,20 @@
 #ifndef HUFFMAN_H_
 #define HUFFMAN_H_
 
+#include "huffman/options.h"
 #include "huffman/state.h"
+#include "huffman/status.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
-void huffman_compress(huffman_state_t *state, FILE *rfd, FILE *wfd);
+bool huffman_compress(huffman_state_t *state, FILE *rfd, FILE *wfd);
+bool huffman_compress_stream(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, FILE *wfd);
+bool huffman_compress_memory(huffman_state_t *state, const huffman_options_t *options, const uint8_t *data,
+                             size_t size, FILE *wfd);
+size_t huffman_compress_bound(const huffman_options_t *options, size_t size);
+huffman_status_t huffman_compress_buffer(const huffman_options_t *options, const uint8_t *src, size_t src_size,
+                                         uint8_t *dst, size_t dst_capacity, size_t *dst_size);
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef HUFFMAN_CONTEXT_H_
+#define HUFFMAN_CONTEXT_H_
+
+#include "huffman/block.h"
+#include "huffman/decode.h"
+#include "huffman/input.h"
+#include "huffman/model.h"
+#include "huffman/options.h"
+#include "huffman/reader.h"
+#include "huffman/state.h"
+#include "huffman/status.h"
+#include "huffman/writer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Contexte de compression ou de décompression réutilisable : toute la mémoire de travail est allouée une fois par
+ * huffman_context_new(). Le dernier codage canonique est gardé d'un appel à l'autre, et un bloc peut le réutiliser
+ * (kHuffmanBlockRepeat) : les trames produites par un contexte doivent alors être décompressées dans le même ordre par
+ * un même contexte. huffman_context_reset() oublie ce codage des deux côtés, la trame suivante est indépendante.
+ */
+typedef struct huffman_context
+{
+	huffman_options_t options;
+	huffman_state_t state;
+	huffman_frame_t encoder;       /*!< \brief Trame en cours de compression. */
+	huffman_frame_t decoder;       /*!< \brief Trame en cours de décompression. */
+	huffman_decode_table_t table;  /*!< \brief Table de décodage du dernier bloc décompressé. */
+	huffman_reader_t reader;
+	huffman_writer_t writer;
+	uint8_t input[HUFFMAN_READER_BUFFER_SIZE];   /*!< \brief Tampon de lecture d'un fichier compressé. */
+	uint8_t output[HUFFMAN_WRITER_BUFFER_SIZE];  /*!< \brief Tampon d'écriture d'un fichier compressé. */
+	uint8_t *scratch;                            /*!< \brief Flux d'un bloc entrelacé lu dans un fichier. */
+	size_t scratch_size;                         /*!< \brief Taille de scratch, alloué au premier besoin. */
+	huffman_model_t *model;                      /*!< \brief Tables des blocs d'ordre 1, allouées au besoin. */
+} huffman_context_t;
+
+huffman_context_t *huffman_context_new(const huffman_options_t *options);
+void huffman_context_reset(huffman_context_t *context);
+void huffman_context_free(huffman_context_t *context);
+uint8_t *huffman_context_scratch(huffman_context_t *context, size_t size);
+huffman_status_t huffman_context_compress(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                          uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+bool huffman_context_compress_input(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer);
+huffman_status_t huffman_context_decompress(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                            uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+bool huffman_context_decompress_range(huffman_context_t *context, FILE *rfd, uint64_t offset, uint64_t length,
+                                      huffman_sink_t sink, void *opaque);
+huffman_status_t huffman_context_decompress_block(huffman_context_t *context, uint32_t block_size, const uint8_t *src,
+                                                  size_t src_size, uint8_t *dst, size_t dst_capacity,
+                                                  size_t *dst_size);
+
+#endif
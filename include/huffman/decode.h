@@ -0,0 +1,59 @@
+#ifndef HUFFMAN_DECODE_H_
+#define HUFFMAN_DECODE_H_
+
+#include "huffman/limits.h"
+#include "huffman/reader.h"
+#include "huffman/tree.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HUFFMAN_DECODE_ROOT_BITS 11
+#define HUFFMAN_DECODE_SUB_BITS 8
+/*
+ * Une sous-table de 2^k entrées est enracinée sur un sous-arbre d'au moins k + 1 feuilles, il y a donc au plus
+ * CHAR_COUNT / (HUFFMAN_DECODE_SUB_BITS + 1) + 1 sous-tables.
+ */
+#define HUFFMAN_DECODE_TABLE_SIZE                                                                                      \
+	((1 << HUFFMAN_DECODE_ROOT_BITS) +                                                                             \
+	 (CHAR_COUNT / (HUFFMAN_DECODE_SUB_BITS + 1) + 1) * (1 << HUFFMAN_DECODE_SUB_BITS))
+
+typedef enum
+{
+	kHuffmanEntrySymbol,
+	kHuffmanEntryTable,
+	kHuffmanEntryNode,
+} huffman_entry_type_t;
+
+typedef struct huffman_decode_entry
+{
+	uint16_t value; /*!< \brief Caractère, position de la sous-table ou noeud où reprendre le parcours. */
+	uint8_t length; /*!< \brief Nombre de bits consommés, ou largeur de la sous-table. */
+	uint8_t type;   /*!< \brief Un huffman_entry_type_t. */
+} huffman_decode_entry_t;
+
+typedef struct huffman_decode_table
+{
+	huffman_decode_entry_t entries[HUFFMAN_DECODE_TABLE_SIZE]; /*!< \brief Table principale puis sous-tables. */
+	uint16_t size;                                             /*!< \brief Nombre d'entrées utilisées. */
+	uint8_t bits;                                              /*!< \brief Bits lus au plus pour un caractère. */
+} huffman_decode_table_t;
+
+/*
+ * Flux d'un bloc entrelacé : le caractère i du bloc est codé dans le flux i % count.
+ */
+typedef struct huffman_streams
+{
+	huffman_reader_t readers[HUFFMAN_STREAMS_MAX]; /*!< \brief Un lecteur en mémoire par flux. */
+	uint8_t count;                                 /*!< \brief Nombre de flux. */
+	uint8_t next;                                  /*!< \brief Flux du prochain caractère à décoder. */
+} huffman_streams_t;
+
+void huffman_decode_table_build(huffman_decode_table_t *table, const huffman_tree_t *tree);
+bool huffman_decode(huffman_reader_t *reader, const huffman_decode_table_t *table, const huffman_tree_t *tree,
+                    uint8_t *data, size_t count);
+bool huffman_decode_streams(huffman_streams_t *streams, const huffman_decode_table_t *table,
+                            const huffman_tree_t *tree, uint8_t *data, size_t count);
+bool huffman_streams_end(huffman_streams_t *streams);
+
+#endif
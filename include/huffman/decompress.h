@@ -0,0 +1,21 @@
+#ifndef HUFFMAN_DECOMPRESS_H_
+#define HUFFMAN_DECOMPRESS_H_
+
+#include "huffman/options.h"
+#include "huffman/state.h"
+#include "huffman/status.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+bool huffman_decompress(huffman_state_t *state, FILE *rfd, FILE *wfd);
+bool huffman_decompress_stream(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, FILE *wfd);
+bool huffman_decompress_sink(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, huffman_sink_t sink,
+                             void *opaque);
+bool huffman_decompress_verify(huffman_state_t *state, const huffman_options_t *options, FILE *rfd);
+huffman_status_t huffman_decompress_buffer(const huffman_options_t *options, const uint8_t *src, size_t src_size,
+                                           uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HUFFMAN_DICTIONARY_H_
+#define HUFFMAN_DICTIONARY_H_
+
+#include "huffman/decode.h"
+#include "huffman/limits.h"
+#include "huffman/state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Fichier de dictionnaire : HUFFMAN_DICTIONARY_MAGIC, la version sur 1 octet, l'identifiant et le nombre moyen de bits
+ * par caractère sur les échantillons (en 1/65536 de bit) sur 4 octets chacun, puis la longueur du codage des 256
+ * caractères sur 4 bits.
+ */
+#define HUFFMAN_DICTIONARY_MAGIC "HUFD"
+#define HUFFMAN_DICTIONARY_VERSION 1
+#define HUFFMAN_DICTIONARY_SIZE (4 + 1 + 4 + 4 + CHAR_COUNT / 2)
+#define HUFFMAN_DICTIONARY_RATE_ONE 65536
+
+/*
+ * Codage canonique appris hors ligne, que les blocs kHuffmanBlockDictionary désignent par son identifiant au lieu
+ * d'écrire un entête. L'arbre et la table de décodage sont construits une fois, au chargement.
+ */
+typedef struct huffman_dictionary
+{
+	uint32_t id;
+	uint32_t rate;                 /*!< \brief Bits par caractère sur les échantillons, en 1/65536 de bit. */
+	uint8_t lengths[CHAR_COUNT];   /*!< \brief Longueur du codage de chaque caractère. */
+	huffman_state_t state;         /*!< \brief Arbre du codage. */
+	huffman_decode_table_t table;  /*!< \brief Table de décodage de l'arbre. */
+} huffman_dictionary_t;
+
+huffman_dictionary_t *huffman_dictionary_new(void);
+bool huffman_dictionary_train(huffman_dictionary_t *dictionary, uint32_t id, const uint64_t count[CHAR_COUNT],
+                              uint8_t max_length);
+bool huffman_dictionary_save(const huffman_dictionary_t *dictionary, FILE *wfd);
+bool huffman_dictionary_load(huffman_dictionary_t *dictionary, FILE *rfd);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HUFFMAN_ERROR_H_
+#define HUFFMAN_ERROR_H_
+
+/*
+ * Taille du message d'erreur, zéro final compris.
+ */
+#define HUFFMAN_ERROR_SIZE 256
+
+/*
+ * La bibliothèque n'écrit rien sur la sortie d'erreur : une fonction qui échoue renvoie false, NULL ou un
+ * huffman_status_t, et décrit la cause avec huffman_error_set(). Le message est propre au thread appelant ; les
+ * échecs des threads de travail sont recopiés dans le thread qui a lancé l'opération. huffman_error() renvoie le
+ * dernier message, à afficher par le programme s'il le souhaite.
+ */
+void huffman_error_set(const char *format, ...);
+const char *huffman_error(void);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HUFFMAN_FORMAT_H_
+#define HUFFMAN_FORMAT_H_
+
+/*
+ * Format par blocs : HUFFMAN_MAGIC, la version sur 1 octet et la taille maximale d'un bloc sur 4 octets, puis une suite
+ * de blocs terminée par un bloc kHuffmanBlockEnd. Un bloc commence par son type sur 1 octet, le nombre de caractères
+ * sur 4 octets et la taille du reste du bloc sur 4 octets. Depuis la version 3, le bloc de fin est suivi du nombre
+ * total de caractères et du nombre de blocs, sur 8 octets chacun. La version 4 ajoute les blocs kHuffmanBlockCanonical,
+ * dont l'entête ne donne que la longueur du codage de chaque caractère, la version 5 les blocs kHuffmanBlockRepeat,
+ * sans entête : ils réutilisent le codage du dernier bloc canonique, la version 6 les blocs kHuffmanBlockDictionary,
+ * dont l'entête est l'identifiant sur 4 octets d'un huffman_dictionary_t, la version 7 les blocs entrelacés, dont les
+ * caractères sont répartis entre plusieurs flux (block.h), la version 8 les blocs kHuffmanBlockContext, dont chaque
+ * caractère est codé selon le précédent (model.h), et la version 9 les blocs kHuffmanBlockStored, dont les caractères
+ * sont copiés tels quels, et kHuffmanBlockRun, dont le seul caractère est écrit une fois sur 1 octet. La version 10
+ * termine chaque bloc par le CRC-32C de ses caractères (HUFFMAN_BLOCK_CHECKSUM) et ajoute au résumé celui de tous les
+ * caractères de la trame, sur 4 octets. L'ancien format (un seul arbre pour tout le fichier) commence par la taille du
+ * fichier dont le cinquième octet vaut 0 ou 1 : une version >= 2 les distingue. Une trame peut être suivie de l'index
+ * de ses blocs (seekable.h), que le décodage depuis le début ignore.
+ */
+#define HUFFMAN_MAGIC "HUFF"
+#define HUFFMAN_MAGIC_SIZE 4
+#define HUFFMAN_FORMAT_VERSION 10
+#define HUFFMAN_FORMAT_VERSION_MIN 2
+/*
+ * Première version dont les blocs et la trame portent le CRC-32C de leurs caractères.
+ */
+#define HUFFMAN_FORMAT_VERSION_CHECKSUM 10
+#define HUFFMAN_FRAME_HEADER_SIZE (HUFFMAN_MAGIC_SIZE + 5)
+/*
+ * Taille du résumé qui suit le bloc de fin d'une trame de cette version.
+ */
+#define HUFFMAN_FRAME_TRAILER_SIZE(version) ((version) < 3 ? 0 : (version) < 10 ? 16 : 20)
+
+typedef enum
+{
+	kHuffmanBlockEnd,
+	kHuffmanBlockTree,
+	kHuffmanBlockCanonical,
+	kHuffmanBlockRepeat,
+	kHuffmanBlockDictionary,
+	kHuffmanBlockContext,
+	kHuffmanBlockStored,
+	kHuffmanBlockRun,
+} huffman_block_type_t;
+
+#endif
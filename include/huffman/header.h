@@ -0,0 +1,20 @@
+#ifndef HUFFMAN_HEADER_H_
+#define HUFFMAN_HEADER_H_
+
+#include "huffman/code.h"
+#include "huffman/limits.h"
+#include "huffman/reader.h"
+#include "huffman/state.h"
+#include "huffman/tree.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+
+void huffman_write_header(huffman_writer_t *writer, const huffman_tree_t *tree);
+void huffman_write_tree(huffman_writer_t *writer, const huffman_tree_t *tree);
+bool huffman_read_header(huffman_reader_t *reader, huffman_state_t *state);
+void huffman_write_lengths(huffman_writer_t *writer, const huffman_state_t *state,
+                           const huffman_code_t code[CHAR_COUNT]);
+bool huffman_read_lengths(huffman_reader_t *reader, uint8_t length[CHAR_COUNT]);
+bool huffman_build_canonical(huffman_state_t *state, const uint8_t length[CHAR_COUNT]);
+
+#endif
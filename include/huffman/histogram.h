@@ -0,0 +1,11 @@
+#ifndef HUFFMAN_HISTOGRAM_H_
+#define HUFFMAN_HISTOGRAM_H_
+
+#include "huffman/limits.h"
+#include <stddef.h>
+#include <stdint.h>
+
+void huffman_histogram(uint64_t count[CHAR_COUNT], const uint8_t *data, size_t size);
+uint32_t huffman_histogram_crc32c(uint64_t count[CHAR_COUNT], uint32_t crc, const uint8_t *data, size_t size);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HUFFMAN_INPUT_H_
+#define HUFFMAN_INPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct huffman_input
+{
+	FILE *rfd;           /*!< \brief Fichier lu avec stdio, ou NULL si data contient toute l'entrée. */
+	const uint8_t *data; /*!< \brief Toute l'entrée (mémoire de l'appelant ou projection du fichier). */
+	size_t size;         /*!< \brief Nombre d'octets dans data. */
+	size_t pos;          /*!< \brief Prochain octet de data à lire. */
+	void *map;           /*!< \brief Projection du fichier, ou NULL. */
+	size_t map_size;     /*!< \brief Taille de la projection. */
+} huffman_input_t;
+
+bool huffman_input_open(huffman_input_t *input, FILE *rfd);
+void huffman_input_memory(huffman_input_t *input, const uint8_t *data, size_t size);
+size_t huffman_input_read(huffman_input_t *input, uint8_t *buffer, size_t size, const uint8_t **block);
+void huffman_input_rewind(huffman_input_t *input);
+bool huffman_input_error(const huffman_input_t *input);
+void huffman_input_close(huffman_input_t *input);
+bool huffman_input_pread(FILE *rfd, uint8_t *data, uint64_t size, uint64_t offset);
+
+#endif
@@ -5,4 +5,31 @@
 
 #define CHAR_COUNT (UCHAR_MAX + 1)
 
+#define HUFFMAN_BLOCK_SIZE_MIN (1 << 12)
+#define HUFFMAN_BLOCK_SIZE_MAX (1 << 24)
+#define HUFFMAN_BLOCK_SIZE_DEFAULT (1 << 20)
+
+/*
+ * Bornes de la longueur maximale d'un codage canonique : 256 caractères demandent au moins 8 bits, et la longueur
+ * est écrite sur 4 bits dans l'entête.
+ */
+#define HUFFMAN_CODE_LENGTH_MIN 8
+#define HUFFMAN_CODE_LENGTH_MAX 15
+
+/*
+ * Nombre maximal de flux entrelacés dans un bloc.
+ */
+#define HUFFMAN_STREAMS_MAX 8
+
+/*
+ * Nombre maximal de tables d'un bloc d'ordre 1 : une par contexte.
+ */
+#define HUFFMAN_CONTEXTS_MAX CHAR_COUNT
+
+/*
+ * Niveau maximal du découpage adaptatif des blocs : sa fenêtre (HUFFMAN_SPLIT_WINDOW()) vaut alors
+ * HUFFMAN_BLOCK_SIZE_MIN.
+ */
+#define HUFFMAN_SPLIT_MAX 5
+
 #endif
@@ -0,0 +1,50 @@
+#ifndef HUFFMAN_MODEL_H_
+#define HUFFMAN_MODEL_H_
+
+#include "huffman/allocator.h"
+#include "huffman/code.h"
+#include "huffman/decode.h"
+#include "huffman/limits.h"
+#include "huffman/reader.h"
+#include "huffman/state.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Table d'un modèle d'ordre 1 : un codage canonique, partagé par les contextes qui lui sont associés.
+ */
+typedef struct huffman_model_table
+{
+	huffman_state_t state;            /*!< \brief Arbre du codage. */
+	huffman_code_t code[CHAR_COUNT];  /*!< \brief Codage de chaque caractère (compression). */
+	huffman_decode_table_t table;     /*!< \brief Table de décodage (décompression). */
+} huffman_model_table_t;
+
+/*
+ * Modèle d'ordre 1 d'un bloc kHuffmanBlockContext : chaque caractère est codé avec la table du caractère qui le
+ * précède, le premier caractère du bloc avec celle de 0. Les 256 contextes sont regroupés en au plus
+ * options.contexts tables pour limiter la taille de l'entête. Après l'entête du bloc viennent le nombre de tables
+ * moins 1 sur 1 octet, la table de chaque contexte sur 1 octet s'il y en a plus d'une, puis les longueurs de chaque
+ * table (huffman_write_lengths()) et les caractères codés.
+ */
+typedef struct huffman_model
+{
+	uint16_t capacity;                        /*!< \brief Nombre de tables allouées. */
+	uint16_t count;                           /*!< \brief Nombre de tables du bloc. */
+	uint8_t map[CHAR_COUNT];                  /*!< \brief Table de chaque contexte. */
+	uint32_t counts[CHAR_COUNT][CHAR_COUNT];  /*!< \brief Histogramme de chaque contexte (compression). */
+	huffman_model_table_t tables[];
+} huffman_model_t;
+
+bool huffman_model_reserve(huffman_model_t **model, const huffman_allocator_t *allocator, uint16_t count);
+void huffman_model_free(huffman_model_t *model, const huffman_allocator_t *allocator);
+void huffman_model_prepare(huffman_model_t *model, const uint8_t *data, size_t size, unsigned tables,
+                           uint8_t max_length, uint64_t *bits, uint32_t *header);
+void huffman_model_write(const huffman_model_t *model, huffman_writer_t *writer, const uint8_t *data, size_t size);
+bool huffman_model_read(huffman_model_t **model, const huffman_allocator_t *allocator, huffman_reader_t *reader);
+bool huffman_model_decode(const huffman_model_t *model, huffman_reader_t *reader, uint8_t *data, size_t count,
+                          uint8_t *last);
+
+#endif
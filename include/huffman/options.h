@@ -0,0 +1,27 @@
+#ifndef HUFFMAN_OPTIONS_H_
+#define HUFFMAN_OPTIONS_H_
+
+#include "huffman/allocator.h"
+#include "huffman/dictionary.h"
+#include "huffman/stats.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct huffman_options
+{
+	size_t block_size;                       /*!< \brief Nombre maximal de caractères par bloc. */
+	unsigned threads;                        /*!< \brief Blocs traités en parallèle (1 : pas de thread). */
+	unsigned max_code_length;                /*!< \brief Longueur maximale des codages (0 : arbre complet). */
+	const huffman_allocator_t *allocator;    /*!< \brief Allocateur des tampons, ou NULL pour malloc(). */
+	const huffman_dictionary_t *dictionary;  /*!< \brief Codage appris hors ligne, ou NULL. */
+	huffman_stats_t *stats;                  /*!< \brief Compteurs remplis par chaque appel, ou NULL. */
+	bool seekable;                           /*!< \brief Blocs indépendants suivis de leur index (seekable.h). */
+	unsigned streams;                        /*!< \brief Flux entrelacés par bloc (1 : un seul flux). */
+	unsigned contexts;                       /*!< \brief Tables d'ordre 1 par bloc, au plus (0 : ordre 0). */
+	unsigned split;                          /*!< \brief Niveau de découpage adaptatif (0 : aucun). */
+} huffman_options_t;
+
+void huffman_options_init(huffman_options_t *options);
+bool huffman_options_check(const huffman_options_t *options);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HUFFMAN_PARALLEL_H_
+#define HUFFMAN_PARALLEL_H_
+
+#include "huffman/block.h"
+#include "huffman/input.h"
+#include "huffman/options.h"
+#include "huffman/reader.h"
+#include "huffman/seekable.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+bool huffman_compress_parallel(const huffman_options_t *options, huffman_input_t *input, huffman_writer_t *writer,
+                               huffman_frame_t *frame, huffman_seek_table_t *seek);
+bool huffman_decompress_parallel(const huffman_options_t *options, huffman_reader_t *reader, uint32_t block_size,
+                                 huffman_writer_t *writer, huffman_frame_t *frame);
+
+#endif
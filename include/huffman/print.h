@@ -0,0 +1,23 @@
+#ifndef HUFFMAN_PRINT_H_
+#define HUFFMAN_PRINT_H_
+
+#include "huffman/code.h"
+#include "huffman/state.h"
+#include "huffman/stats.h"
+#include <stdio.h>
+
+/*
+ * La bibliothèque n'écrit rien sur la sortie standard : les diagnostics sont demandés par l'appelant.
+ */
+typedef enum
+{
+	kHuffmanVerbositySilent,  /*!< \brief Aucun affichage. */
+	kHuffmanVerbosityGain,    /*!< \brief Tailles originelle et compressée, gain. */
+	kHuffmanVerbosityDetails, /*!< \brief Blocs, longueur moyenne du codage et compteurs de huffman_stats_t. */
+	kHuffmanVerbosityTree,    /*!< \brief Arbre et codage de chaque caractère (huffman_print()). */
+} huffman_verbosity_t;
+
+void huffman_report(const huffman_stats_t *stats, huffman_verbosity_t verbosity, FILE *file);
+void huffman_print(const huffman_state_t *state, const huffman_code_t code[CHAR_COUNT]);
+
+#endif
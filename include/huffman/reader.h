@@ -0,0 +1,92 @@
+#ifndef HUFFMAN_READER_H_
+#define HUFFMAN_READER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HUFFMAN_READER_BUFFER_SIZE (1 << 16)
+
+typedef struct huffman_reader
+{
+	FILE *rfd;            /*!< \brief Fichier lu par blocs dans buffer, ou NULL si data contient toute l'entrée. */
+	uint8_t *buffer;      /*!< \brief Tampon de lecture de rfd. */
+	size_t capacity;      /*!< \brief Taille de buffer. */
+	const uint8_t *data;  /*!< \brief Octets disponibles (buffer, ou la mémoire lue). */
+	size_t pos;           /*!< \brief Prochain octet de data à charger dans bits. */
+	size_t end;           /*!< \brief Nombre d'octets disponibles dans data. */
+	uint64_t base;        /*!< \brief Octets de l'entrée déjà retirés de data. */
+	uint64_t bits;        /*!< \brief Bits en attente, alignés sur le bit de poids fort. */
+	uint8_t count;        /*!< \brief Nombre de bits valides dans bits. */
+	uint64_t padding;     /*!< \brief Bits nuls ajoutés après la fin de l'entrée. */
+	bool ranged;          /*!< \brief rfd est lu avec pread() dans une plage (huffman_reader_init_range()). */
+	uint64_t offset;      /*!< \brief Position dans rfd du prochain octet de la plage. */
+	uint64_t remaining;   /*!< \brief Octets de la plage encore à lire. */
+} huffman_reader_t;
+
+void huffman_reader_init_file(huffman_reader_t *reader, FILE *rfd, uint8_t *buffer, size_t capacity);
+void huffman_reader_init_range(huffman_reader_t *reader, FILE *rfd, uint64_t offset, uint64_t size, uint8_t *buffer,
+                               size_t capacity);
+void huffman_reader_init_memory(huffman_reader_t *reader, const uint8_t *data, size_t size);
+void huffman_reader_fill(huffman_reader_t *reader);
+uint64_t huffman_reader_tell(const huffman_reader_t *reader);
+void huffman_reader_align(huffman_reader_t *reader);
+bool huffman_reader_bytes(huffman_reader_t *reader, uint8_t *data, size_t size);
+const uint8_t *huffman_reader_take(huffman_reader_t *reader, size_t size, uint8_t *scratch);
+
+static inline uint64_t huffman_load_be64(const uint8_t *p)
+{
+	return (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 | (uint64_t)p[3] << 32 |
+	       (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 | (uint64_t)p[6] << 8 | (uint64_t)p[7];
+}
+
+static inline uint32_t huffman_load_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+/*
+ * Complète bits jusqu'à au moins 56 bits, par un seul chargement de 8 octets lorsqu'ils sont disponibles (le chemin
+ * lent en donne 57). Un appelant qui lit plusieurs codages par remplissage ne compte que sur 56 bits.
+ */
+static inline void huffman_reader_refill(huffman_reader_t *reader)
+{
+	if (reader->count > 56)
+		return;
+	if (reader->end - reader->pos < 8)
+	{
+		huffman_reader_fill(reader);
+		return;
+	}
+	reader->bits |= huffman_load_be64(reader->data + reader->pos) >> reader->count;
+	reader->pos += (63 - reader->count) >> 3;
+	reader->count |= 56;
+}
+
+static inline void huffman_reader_consume(huffman_reader_t *reader, uint8_t n)
+{
+	reader->bits <<= n;
+	reader->count -= n;
+}
+
+/*
+ * Lit un champ de n bits (1 <= n <= 32).
+ */
+static inline uint32_t huffman_reader_get(huffman_reader_t *reader, uint8_t n)
+{
+	huffman_reader_refill(reader);
+	uint32_t value = reader->bits >> (64 - n);
+	huffman_reader_consume(reader, n);
+	return value;
+}
+
+/*
+ * Vrai si des bits ajoutés après la fin de l'entrée ont été consommés.
+ */
+static inline bool huffman_reader_truncated(const huffman_reader_t *reader)
+{
+	return reader->count < reader->padding;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HUFFMAN_SEEKABLE_H_
+#define HUFFMAN_SEEKABLE_H_
+
+#include "huffman/allocator.h"
+#include "huffman/context.h"
+#include "huffman/options.h"
+#include "huffman/status.h"
+#include "huffman/writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Index des blocs, écrit après le résumé de la trame avec options.seekable : le nombre de caractères et la taille du
+ * reste de chaque bloc sur 4 octets chacun (comme dans son entête), puis le nombre de blocs sur 8 octets et
+ * HUFFMAN_SEEK_MAGIC. Un décodeur qui lit la trame depuis le début s'arrête au bloc de fin et ignore l'index.
+ */
+#define HUFFMAN_SEEK_MAGIC "HUFS"
+#define HUFFMAN_SEEK_ENTRY_SIZE 8
+#define HUFFMAN_SEEK_FOOTER_SIZE (8 + 4)
+#define HUFFMAN_SEEK_CACHE_DEFAULT 8
+
+typedef struct huffman_seek_entry
+{
+	uint32_t size;   /*!< \brief Nombre de caractères du bloc. */
+	uint32_t length; /*!< \brief Taille du bloc compressé après son entête. */
+} huffman_seek_entry_t;
+
+/*
+ * Index construit pendant la compression.
+ */
+typedef struct huffman_seek_table
+{
+	huffman_seek_entry_t *entries;
+	uint64_t count;
+	uint64_t capacity;
+} huffman_seek_table_t;
+
+typedef struct huffman_seek_slot
+{
+	uint8_t *data;  /*!< \brief Caractères décodés du bloc. */
+	uint64_t block; /*!< \brief Numéro du bloc, ou UINT64_MAX si l'emplacement est libre. */
+	uint64_t used;  /*!< \brief Horloge du dernier accès. */
+} huffman_seek_slot_t;
+
+/*
+ * Lecture par positions d'un fichier compressé avec son index : seuls les blocs qui contiennent les caractères
+ * demandés sont lus et décodés, et les derniers blocs décodés sont gardés (le moins récemment utilisé est remplacé).
+ * Un huffman_seekable_t ne doit être utilisé que par un thread à la fois.
+ */
+typedef struct huffman_seekable
+{
+	FILE *rfd;
+	huffman_context_t *context;
+	uint32_t block_size;
+	uint64_t size;               /*!< \brief Nombre total de caractères. */
+	uint64_t count;              /*!< \brief Nombre de blocs. */
+	uint64_t *offsets;           /*!< \brief Position du premier caractère de chaque bloc, puis size. */
+	uint64_t *positions;         /*!< \brief Position de chaque bloc (son entête) dans le fichier. */
+	uint8_t *buffer;             /*!< \brief Bloc compressé en cours de décodage. */
+	huffman_seek_slot_t *cache;
+	size_t cache_size;
+	uint64_t clock;
+} huffman_seekable_t;
+
+void huffman_seek_table_init(huffman_seek_table_t *table);
+bool huffman_seek_table_add(huffman_seek_table_t *table, const huffman_allocator_t *allocator, uint32_t size,
+                            uint32_t length);
+void huffman_seek_table_write(const huffman_seek_table_t *table, huffman_writer_t *writer);
+void huffman_seek_table_free(huffman_seek_table_t *table, const huffman_allocator_t *allocator);
+
+huffman_seekable_t *huffman_seekable_open(const huffman_options_t *options, FILE *rfd, size_t cache_size);
+huffman_status_t huffman_seekable_pread(huffman_seekable_t *seekable, uint8_t *dst, size_t size, uint64_t offset,
+                                        size_t *dst_size);
+void huffman_seekable_close(huffman_seekable_t *seekable);
+
+#endif
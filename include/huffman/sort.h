@@ -1,9 +1,10 @@
 #ifndef HUFFMAN_SORT_H_
 #define HUFFMAN_SORT_H_
 
+#include "huffman/limits.h"
 #include "huffman/state.h"
 #include <stdint.h>
 
-void huffman_heapsort(huffman_state_t *state, uint16_t *array, uint16_t size);
+void huffman_sort_leaves(huffman_state_t *state, uint32_t freq[CHAR_COUNT]);
 
 #endif
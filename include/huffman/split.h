@@ -0,0 +1,16 @@
+#ifndef HUFFMAN_SPLIT_H_
+#define HUFFMAN_SPLIT_H_
+
+#include "huffman/limits.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fenêtre comparée au bloc en cours au niveau level de options.split : 64 Ko au niveau 1, la moitié à chaque niveau
+ * suivant. Aucun bloc découpé n'est plus court, sauf le dernier de l'entrée.
+ */
+#define HUFFMAN_SPLIT_WINDOW(level) ((size_t)1 << (17 - (level)))
+
+size_t huffman_split(const uint8_t *data, size_t size, unsigned level);
+
+#endif
@@ -10,7 +10,8 @@ typedef struct huffman_state
 	huffman_tree_t tree;
 	uint16_t leaves[CHAR_COUNT]; /*!< \brief Tableau de feuilles de taille 256. */
 	uint16_t num_leaves;          /*!< \brief Nombre de feuilles. */
-	size_t file_size;             /*!< \brief Nombre de caractères dans le fichier. */
+	uint64_t file_size;           /*!< \brief Nombre de caractères dans le fichier. */
+	uint8_t version;              /*!< \brief Version du format par blocs écrit ou lu, 0 pour l'ancien format. */
 } huffman_state_t;
 
 huffman_state_t *huffman_state_new(void);
@@ -0,0 +1,77 @@
+#ifndef HUFFMAN_STATS_H_
+#define HUFFMAN_STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+	kHuffmanStageHistogram, /*!< \brief Comptage des caractères. */
+	kHuffmanStageSort,      /*!< \brief Tri des feuilles (huffman_sort_leaves()). */
+	kHuffmanStageBuild,     /*!< \brief Construction de l'arbre, hors tri. */
+	kHuffmanStageCode,      /*!< \brief Calcul des codages. */
+	kHuffmanStageWrite,     /*!< \brief Écriture des entêtes et des caractères codés. */
+	kHuffmanStageTable,     /*!< \brief Lecture des entêtes et construction des tables de décodage. */
+	kHuffmanStageDecode,    /*!< \brief Décodage des caractères. */
+	kHuffmanStageChecksum,  /*!< \brief CRC-32C des caractères décodés (compté avec l'histogramme à la compression). */
+	kHuffmanStageCount,
+} huffman_stage_t;
+
+/*
+ * Compteurs d'un appel de compression ou de décompression, remplis seulement si la bibliothèque est compilée avec
+ * HUFFMAN_STATS (make STATS=1). Les durées des threads s'additionnent. Les totaux d'une compression (bytes_in,
+ * bytes_out, blocks et bits) sont toujours remplis : ils sont relevés une fois à la fin de la trame.
+ */
+typedef struct huffman_stats
+{
+	uint64_t time[kHuffmanStageCount]; /*!< \brief Durée de chaque étape, en nanosecondes. */
+	uint64_t bytes_in;                 /*!< \brief Octets lus. */
+	uint64_t bytes_out;                /*!< \brief Octets écrits. */
+	uint64_t blocks;                   /*!< \brief Nombre de blocs. */
+	uint64_t bits;                     /*!< \brief Bits des caractères codés, sans les entêtes (compression). */
+	uint16_t symbols;                  /*!< \brief Plus grand nombre de caractères différents dans un bloc. */
+	uint8_t max_code_length;           /*!< \brief Plus long codage utilisé. */
+	uint64_t allocations;              /*!< \brief Nombre d'appels à huffman_alloc(). */
+	uint64_t allocated;                /*!< \brief Octets demandés à huffman_alloc(). */
+} huffman_stats_t;
+
+huffman_stats_t *huffman_stats_begin(huffman_stats_t *stats);
+void huffman_stats_end(huffman_stats_t *previous);
+void huffman_stats_merge(huffman_stats_t *stats, const huffman_stats_t *other);
+void huffman_stats_dump(const huffman_stats_t *stats, FILE *file);
+const char *huffman_stats_stage_name(huffman_stage_t stage);
+
+#ifdef HUFFMAN_STATS
+/*
+ * Compteurs de l'appel en cours dans ce thread, ou NULL.
+ */
+extern _Thread_local huffman_stats_t *huffman_stats_current;
+uint64_t huffman_stats_now(void);
+
+#define HUFFMAN_STATS_START(start) uint64_t start = huffman_stats_current != NULL ? huffman_stats_now() : 0
+#define HUFFMAN_STATS_STOP(stage, start)                                                                               \
+	do                                                                                                             \
+	{                                                                                                              \
+		if (huffman_stats_current != NULL)                                                                     \
+			huffman_stats_current->time[stage] += huffman_stats_now() - (start);                           \
+	} while (0)
+#define HUFFMAN_STATS_ADD(field, n)                                                                                    \
+	do                                                                                                             \
+	{                                                                                                              \
+		if (huffman_stats_current != NULL)                                                                     \
+			huffman_stats_current->field += (n);                                                           \
+	} while (0)
+#define HUFFMAN_STATS_MAX(field, n)                                                                                    \
+	do                                                                                                             \
+	{                                                                                                              \
+		if (huffman_stats_current != NULL && huffman_stats_current->field < (n))                              \
+			huffman_stats_current->field = (n);                                                            \
+	} while (0)
+#else
+#define HUFFMAN_STATS_START(start) ((void)0)
+#define HUFFMAN_STATS_STOP(stage, start) ((void)0)
+#define HUFFMAN_STATS_ADD(field, n) ((void)0)
+#define HUFFMAN_STATS_MAX(field, n) ((void)0)
+#endif
+
+#endif
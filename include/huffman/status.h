@@ -0,0 +1,13 @@
+#ifndef HUFFMAN_STATUS_H_
+#define HUFFMAN_STATUS_H_
+
+typedef enum
+{
+	kHuffmanOk,
+	kHuffmanErrorArgument, /*!< \brief Options invalides. */
+	kHuffmanErrorMemory,   /*!< \brief Allocation mémoire ou création de thread impossible. */
+	kHuffmanErrorSize,     /*!< \brief Le tampon de sortie est trop petit. */
+	kHuffmanErrorData,     /*!< \brief Données compressées invalides ou tronquées. */
+} huffman_status_t;
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef HUFFMAN_STREAM_H_
+#define HUFFMAN_STREAM_H_
+
+#include "huffman/context.h"
+#include "huffman/options.h"
+#include "huffman/status.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+	kHuffmanStreamHeader,  /*!< \brief Entête de la trame, ou taille du fichier de l'ancien format. */
+	kHuffmanStreamBlock,   /*!< \brief Entête d'un bloc (son type, puis sa taille). */
+	kHuffmanStreamData,    /*!< \brief Reste d'un bloc. */
+	kHuffmanStreamTrailer, /*!< \brief Résumé de la trame. */
+	kHuffmanStreamTree,    /*!< \brief Entête d'arbre de l'ancien format. */
+	kHuffmanStreamBits,    /*!< \brief Caractères codés de l'ancien format. */
+	kHuffmanStreamEnd,     /*!< \brief Trame terminée. */
+} huffman_stream_stage_t;
+
+/*
+ * Décompression incrémentale, sans fichier ni thread : les octets compressés sont donnés par morceaux de taille
+ * quelconque à huffman_stream_feed(), et les caractères décodés repris par huffman_stream_read(). Un bloc du format
+ * par blocs est décodé dès qu'il est reçu en entier ; le flux ne garde qu'un bloc compressé et un bloc décodé.
+ * L'ancien format ne donne pas la taille des données compressées : le flux ne prend que les octets qui en font
+ * sûrement partie et les décode avec la table ; seuls les bits d'un codage incomplet sont gardés pour la suite. Un
+ * fichier vide compressé dans l'ancien format est vide lui aussi, le flux n'en voit donc jamais la fin.
+ */
+typedef struct huffman_stream
+{
+	huffman_context_t *context; /*!< \brief Arbre, table de décodage et codage réutilisé par les blocs répétés. */
+	huffman_stream_stage_t stage;
+	huffman_status_t status;    /*!< \brief Première erreur, renvoyée jusqu'à huffman_stream_reset(). */
+	uint8_t version;
+	uint32_t block_size;
+	uint8_t *input;             /*!< \brief Octets reçus pour l'étape en cours. */
+	size_t received;            /*!< \brief Nombre d'octets reçus dans input. */
+	size_t expected;            /*!< \brief Nombre d'octets qui terminent l'étape en cours. */
+	size_t capacity;            /*!< \brief Taille de input. */
+	uint8_t *output;            /*!< \brief Caractères du dernier bloc décodé. */
+	size_t pos;                 /*!< \brief Prochain caractère de output à lire. */
+	size_t size;                /*!< \brief Nombre de caractères dans output. */
+	uint64_t total;             /*!< \brief Nombre de caractères des blocs déjà décodés. */
+	uint64_t blocks;            /*!< \brief Nombre de blocs déjà décodés. */
+	uint64_t remaining;         /*!< \brief Caractères de l'ancien format qui restent à décoder. */
+	uint16_t node;              /*!< \brief Noeud atteint dans l'arbre de l'ancien format. */
+	uint8_t depth;              /*!< \brief Longueur du plus long codage de l'ancien format. */
+	uint8_t offset;             /*!< \brief Bits déjà décodés du premier octet de input (ancien format). */
+} huffman_stream_t;
+
+huffman_stream_t *huffman_stream_new(const huffman_options_t *options);
+void huffman_stream_reset(huffman_stream_t *stream);
+void huffman_stream_free(huffman_stream_t *stream);
+huffman_status_t huffman_stream_feed(huffman_stream_t *stream, const uint8_t *src, size_t src_size, size_t *consumed);
+huffman_status_t huffman_stream_read(huffman_stream_t *stream, uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+bool huffman_stream_finished(const huffman_stream_t *stream);
+
+#endif
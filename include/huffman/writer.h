@@ -0,0 +1,64 @@
+#ifndef HUFFMAN_WRITER_H_
+#define HUFFMAN_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HUFFMAN_WRITER_BUFFER_SIZE (1 << 16)
+/*
+ * Taille du tampon de sortie de la décompression d'un fichier : les caractères décodés sont écrits par tranches de
+ * cette taille.
+ */
+#define HUFFMAN_OUTPUT_BUFFER_SIZE (1 << 20)
+
+/*
+ * Destination fournie par l'appelant, qui reçoit le contenu du tampon à chaque vidage. Renvoie faux en cas d'erreur.
+ */
+typedef bool (*huffman_sink_t)(void *opaque, const uint8_t *data, size_t size);
+
+typedef struct huffman_writer
+{
+	uint8_t *data;       /*!< \brief Tampon de sortie. */
+	size_t size;         /*!< \brief Nombre d'octets écrits dans data. */
+	size_t capacity;     /*!< \brief Taille de data. */
+	FILE *wfd;           /*!< \brief Fichier où vider data lorsqu'il est plein. */
+	huffman_sink_t sink; /*!< \brief Destination où vider data à la place de wfd, ou NULL. */
+	void *opaque;        /*!< \brief Passé tel quel à sink. */
+	uint64_t acc;        /*!< \brief Bits en attente, alignés sur le bit de poids fort. */
+	uint8_t count;       /*!< \brief Nombre de bits en attente dans acc (toujours < 64). */
+	bool failed;         /*!< \brief Une écriture a échoué. */
+	uint64_t written;    /*!< \brief Nombre d'octets déjà vidés dans wfd ou sink. */
+} huffman_writer_t;
+
+void huffman_writer_init(huffman_writer_t *writer, uint8_t *data, size_t capacity, FILE *wfd);
+void huffman_writer_init_sink(huffman_writer_t *writer, uint8_t *data, size_t capacity, huffman_sink_t sink,
+                              void *opaque);
+void huffman_writer_word(huffman_writer_t *writer, uint64_t word);
+void huffman_writer_align(huffman_writer_t *writer);
+uint64_t huffman_writer_tell(const huffman_writer_t *writer);
+void huffman_writer_bytes(huffman_writer_t *writer, const uint8_t *data, size_t size);
+bool huffman_writer_finish(huffman_writer_t *writer);
+bool huffman_writer_flush(huffman_writer_t *writer);
+const char *huffman_writer_error(const huffman_writer_t *writer);
+
+/*
+ * Ajoute les length bits de poids faible de value (1 <= length <= 64, les autres bits de value doivent être nuls).
+ * Un mot de 64 bits n'est écrit dans le tampon que lorsque acc est plein.
+ */
+static inline void huffman_writer_put(huffman_writer_t *writer, uint64_t value, uint8_t length)
+{
+	if (writer->count + length < 64)
+	{
+		writer->acc |= value << (64 - writer->count - length);
+		writer->count += length;
+		return;
+	}
+	uint8_t spill = writer->count + length - 64;
+	huffman_writer_word(writer, writer->acc | value >> spill);
+	writer->acc = spill ? value << (64 - spill) : 0;
+	writer->count = spill;
+}
+
+#endif
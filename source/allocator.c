@@ -0,0 +1,37 @@
+#include "huffman/allocator.h"
+#include "huffman/stats.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Sans allocateur, malloc() et free() sont utilisés.
+ */
+void *huffman_alloc(const huffman_allocator_t *allocator, size_t size)
+{
+	HUFFMAN_STATS_ADD(allocations, 1);
+	HUFFMAN_STATS_ADD(allocated, size);
+	if (allocator == NULL)
+		return malloc(size);
+	return allocator->alloc(allocator->opaque, size);
+}
+
+void *huffman_calloc(const huffman_allocator_t *allocator, size_t count, size_t size)
+{
+	if (size != 0 && count > SIZE_MAX / size)
+		return NULL;
+	void *data = huffman_alloc(allocator, count * size);
+	if (data != NULL)
+		memset(data, 0, count * size);
+	return data;
+}
+
+void huffman_free(const huffman_allocator_t *allocator, void *data)
+{
+	if (data == NULL)
+		return;
+	if (allocator == NULL)
+		free(data);
+	else if (allocator->free != NULL)
+		allocator->free(allocator->opaque, data);
+}
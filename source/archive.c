@@ -0,0 +1,810 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/archive.h"
+#include "huffman/block.h"
+#include "huffman/compress.h"
+#include "huffman/context.h"
+#include "huffman/error.h"
+#include "huffman/input.h"
+#include "huffman/reader.h"
+#include "huffman/writer.h"
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Taille minimale d'un membre dans l'index : nom vide, trois tailles et le CRC.
+ */
+#define ENTRY_SIZE_MIN (2 + 8 + 8 + 8 + 4)
+/*
+ * Plus petit bloc d'une trame : un bloc kHuffmanBlockRun sans somme de contrôle, qui donne au plus
+ * HUFFMAN_BLOCK_SIZE_MAX caractères.
+ */
+#define BLOCK_LENGTH_MIN (HUFFMAN_BLOCK_HEADER_SIZE + 1)
+
+typedef struct file
+{
+	char *path; /*!< \brief Chemin sur le disque. */
+	char *name; /*!< \brief Nom dans l'archive. */
+} file_t;
+
+typedef struct listing
+{
+	file_t *files;
+	size_t count;
+	size_t capacity;
+} listing_t;
+
+typedef struct member
+{
+	uint8_t *data;         /*!< \brief Trame compressée en mémoire, en attente d'écriture, ou NULL. */
+	size_t length;
+	FILE *rfd;             /*!< \brief Fichier ouvert, à compresser directement dans l'archive, ou NULL. */
+	huffman_input_t input; /*!< \brief Projection de rfd. */
+	bool done;             /*!< \brief Le membre a été traité par un thread. */
+	bool ok;
+	char *error;           /*!< \brief Message de l'échec du thread, recopié par l'appelant, ou NULL. */
+} member_t;
+
+/*
+ * Membres traités par un groupe de threads, chacun avec son contexte : un thread prend le membre next suivant. À la
+ * création, les trames sont écrites dans l'ordre de l'index par l'appelant ; un thread n'a pas plus de window membres
+ * d'avance sur la dernière trame écrite. Seul un membre d'au plus options.block_size caractères est compressé en
+ * mémoire par un thread : les autres sont compressés par l'appelant directement dans l'archive, ce qui borne la
+ * mémoire quelle que soit la taille des fichiers.
+ */
+typedef struct pool
+{
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	huffman_options_t options;         /*!< \brief Options de chaque membre : un seul thread par trame. */
+	huffman_archive_entry_t *entries;
+	const listing_t *listing;          /*!< \brief Fichiers à compresser, ou NULL pour une extraction. */
+	const huffman_archive_t *archive;  /*!< \brief Archive à extraire. */
+	const char *directory;             /*!< \brief Répertoire où extraire les membres. */
+	member_t *members;
+	size_t count;
+	size_t next;                       /*!< \brief Prochain membre à traiter. */
+	size_t written;                    /*!< \brief Nombre de trames déjà écrites. */
+	size_t window;
+	bool failed;
+	char error[HUFFMAN_ERROR_SIZE];    /*!< \brief Message du premier échec d'un thread d'extraction. */
+} pool_t;
+
+static bool walk(listing_t *listing, const char *path, const char *name, bool follow);
+static char *join(const char *prefix, const char *name);
+static int compare_files(const void *a, const void *b);
+static void free_listing(listing_t *listing);
+static bool write_archive(pool_t *pool, unsigned threads, FILE *wfd);
+static bool run(pool_t *pool, unsigned threads, void *(*work)(void *), pthread_t *ids, unsigned *started);
+static void stop(pool_t *pool, pthread_t *ids, unsigned started);
+static void *compress_work(void *arg);
+static bool open_member(const file_t *file, member_t *member);
+static void close_member(member_t *member);
+static bool compress_member(huffman_context_t *context, const file_t *file, huffman_archive_entry_t *entry,
+                            member_t *member);
+static bool stream_member(huffman_context_t *context, const file_t *file, huffman_archive_entry_t *entry,
+                          member_t *member, huffman_writer_t *writer);
+static void *extract_work(void *arg);
+static void fail(pool_t *pool);
+static bool extract_file(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                         huffman_context_t *context, const char *directory);
+static bool extract_member(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                           huffman_context_t *context, FILE *wfd);
+static bool write_file(void *opaque, const uint8_t *data, size_t size);
+static uint64_t get64(huffman_reader_t *reader);
+static bool valid_name(const char *name);
+static bool make_parents(char *path);
+
+/*
+ * Archive les fichiers réguliers de paths, en parcourant les répertoires. Le nom d'un membre commence par le dernier
+ * composant de l'argument qui le contient (le contenu de "." est archivé sans préfixe), et les membres sont triés par
+ * nom. options->threads fichiers sont compressés en parallèle, chacun en une trame avec les autres options ; les blocs
+ * d'un fichier plus grand qu'un bloc sont compressés en parallèle à la place.
+ */
+bool huffman_archive_create(const huffman_options_t *options, char *const *paths, size_t count, FILE *wfd)
+{
+	listing_t listing = {0};
+	pool_t pool = {.options = *options, .listing = &listing};
+	bool ok = true;
+
+	if (!huffman_options_check(options))
+		return false;
+	for (size_t i = 0; i < count && ok; i++)
+	{
+		size_t length = strlen(paths[i]);
+		while (length > 1 && paths[i][length - 1] == '/')
+			length--;
+		const char *base = paths[i] + length;
+		while (base > paths[i] && base[-1] != '/')
+			base--;
+		char *name = strndup(base, paths[i] + length - base);
+		if (name == NULL)
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			ok = false;
+			break;
+		}
+		if (!valid_name(name))
+			name[0] = '\0';
+		ok = walk(&listing, paths[i], name, true);
+		free(name);
+	}
+	if (ok)
+	{
+		qsort(listing.files, listing.count, sizeof(file_t), compare_files);
+		pool.count = listing.count;
+		pool.entries = calloc(listing.count + 1, sizeof(huffman_archive_entry_t));
+		pool.members = calloc(listing.count + 1, sizeof(member_t));
+		if (pool.entries == NULL || pool.members == NULL)
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			ok = false;
+		}
+	}
+	if (ok)
+	{
+		pool.options.threads = 1;
+		pool.options.stats = NULL;
+		pool.window = 2 * (size_t)options->threads;
+		ok = write_archive(&pool, options->threads, wfd);
+	}
+	free_listing(&listing);
+	free(pool.entries);
+	free(pool.members);
+	return ok;
+}
+
+/*
+ * Lit l'index central de l'archive rfd, qui doit rester ouverte jusqu'à huffman_archive_close().
+ */
+huffman_archive_t *huffman_archive_open(FILE *rfd)
+{
+	uint8_t header[HUFFMAN_ARCHIVE_HEADER_SIZE];
+	uint8_t trailer[HUFFMAN_ARCHIVE_TRAILER_SIZE];
+	huffman_reader_t reader;
+	struct stat info;
+
+	if (fstat(fileno(rfd), &info) != 0 || !S_ISREG(info.st_mode) ||
+	    (uint64_t)info.st_size < HUFFMAN_ARCHIVE_HEADER_SIZE + HUFFMAN_ARCHIVE_TRAILER_SIZE ||
+	    !huffman_input_pread(rfd, header, sizeof(header), 0) ||
+	    !huffman_input_pread(rfd, trailer, sizeof(trailer), info.st_size - sizeof(trailer)) ||
+	    memcmp(header, HUFFMAN_ARCHIVE_MAGIC, 4) != 0 || header[4] != HUFFMAN_ARCHIVE_VERSION ||
+	    memcmp(trailer + 16, HUFFMAN_ARCHIVE_MAGIC, 4) != 0)
+	{
+		huffman_error_set("Archive invalide.");
+		return NULL;
+	}
+	uint64_t index = huffman_load_be64(trailer);
+	uint64_t count = huffman_load_be64(trailer + 8);
+	uint64_t end = info.st_size - sizeof(trailer);
+	if (index < HUFFMAN_ARCHIVE_HEADER_SIZE || index > end || count > (end - index) / ENTRY_SIZE_MIN)
+	{
+		huffman_error_set("Archive invalide.");
+		return NULL;
+	}
+
+	huffman_archive_t *archive = calloc(1, sizeof(huffman_archive_t));
+	uint8_t *buffer = malloc(end - index + 1);
+	if (archive == NULL || buffer == NULL ||
+	    (archive->entries = calloc(count + 1, sizeof(huffman_archive_entry_t))) == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		free(archive);
+		free(buffer);
+		return NULL;
+	}
+	archive->rfd = rfd;
+	bool ok = huffman_input_pread(rfd, buffer, end - index, index);
+	huffman_reader_init_memory(&reader, buffer, end - index);
+	for (; ok && archive->count < count; archive->count++)
+	{
+		huffman_archive_entry_t *entry = &archive->entries[archive->count];
+		uint16_t length = huffman_reader_get(&reader, 16);
+		if ((entry->name = malloc(length + 1)) == NULL)
+			break;
+		for (uint16_t i = 0; i < length; i++)
+			entry->name[i] = huffman_reader_get(&reader, 8);
+		entry->name[length] = '\0';
+		entry->offset = get64(&reader);
+		entry->length = get64(&reader);
+		entry->size = get64(&reader);
+		entry->checksum = huffman_reader_get(&reader, 32);
+		ok = !huffman_reader_truncated(&reader) && strlen(entry->name) == length && valid_name(entry->name) &&
+		     entry->offset >= HUFFMAN_ARCHIVE_HEADER_SIZE && entry->offset <= index &&
+		     entry->length <= index - entry->offset && entry->size < SIZE_MAX &&
+		     entry->size / HUFFMAN_BLOCK_SIZE_MAX <= entry->length / BLOCK_LENGTH_MIN;
+	}
+	free(buffer);
+	if (!ok || archive->count < count)
+	{
+		if (ok)
+			huffman_error_set("Allocation mémoire dynamique.");
+		else
+			huffman_error_set("Archive invalide.");
+		huffman_archive_close(archive);
+		return NULL;
+	}
+	return archive;
+}
+
+const huffman_archive_entry_t *huffman_archive_find(const huffman_archive_t *archive, const char *name)
+{
+	for (uint64_t i = 0; i < archive->count; i++)
+		if (strcmp(archive->entries[i].name, name) == 0)
+			return &archive->entries[i];
+	return NULL;
+}
+
+/*
+ * Décompresse le seul membre entry dans wfd : sa trame est lue directement à sa position, sans lire les autres.
+ */
+bool huffman_archive_extract(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                             const huffman_options_t *options, FILE *wfd)
+{
+	huffman_options_t member = *options;
+	member.threads = 1;
+	member.stats = NULL;
+	huffman_context_t *context = huffman_context_new(&member);
+	if (context == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	bool ok = extract_member(archive, entry, context, wfd);
+	huffman_context_free(context);
+	return ok;
+}
+
+/*
+ * Extrait tous les membres sous directory, en créant les répertoires intermédiaires. options->threads membres sont
+ * décompressés en parallèle.
+ */
+bool huffman_archive_extract_all(const huffman_archive_t *archive, const huffman_options_t *options,
+                                 const char *directory)
+{
+	pool_t pool = {.options = *options, .archive = archive, .directory = directory, .count = archive->count};
+	pthread_t *ids = NULL;
+	unsigned started = 0;
+	bool ok = true;
+
+	pool.options.threads = 1;
+	pool.options.stats = NULL;
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.changed, NULL);
+	if (options->threads <= 1)
+	{
+		extract_work(&pool);
+	}
+	else if ((ids = calloc(options->threads, sizeof(pthread_t))) == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		ok = false;
+	}
+	else
+	{
+		ok = run(&pool, options->threads, extract_work, ids, &started);
+		for (unsigned i = 0; i < started; i++)
+			pthread_join(ids[i], NULL);
+	}
+	pthread_mutex_destroy(&pool.lock);
+	pthread_cond_destroy(&pool.changed);
+	free(ids);
+	if (ok && pool.failed)
+		huffman_error_set("%s", pool.error);
+	return ok && !pool.failed;
+}
+
+void huffman_archive_close(huffman_archive_t *archive)
+{
+	if (archive == NULL)
+		return;
+	for (uint64_t i = 0; i < archive->count; i++)
+		free(archive->entries[i].name);
+	free(archive->entries);
+	free(archive);
+}
+
+/*
+ * Ajoute path à listing sous le nom name, ou son contenu si c'est un répertoire. Les liens symboliques ne sont suivis
+ * que pour les arguments (follow).
+ */
+static bool walk(listing_t *listing, const char *path, const char *name, bool follow)
+{
+	struct stat info;
+	bool ok = true;
+
+	if ((follow ? stat(path, &info) : lstat(path, &info)) != 0)
+	{
+		huffman_error_set("Fichier %s introuvable.", path);
+		return false;
+	}
+	if (S_ISDIR(info.st_mode))
+	{
+		DIR *dir = opendir(path);
+		struct dirent *child;
+		if (dir == NULL)
+		{
+			huffman_error_set("Lecture du répertoire %s.", path);
+			return false;
+		}
+		while (ok && (child = readdir(dir)) != NULL)
+		{
+			if (strcmp(child->d_name, ".") == 0 || strcmp(child->d_name, "..") == 0)
+				continue;
+			char *child_path = join(path, child->d_name);
+			char *child_name = join(name, child->d_name);
+			ok = child_path != NULL && child_name != NULL && walk(listing, child_path, child_name, false);
+			free(child_path);
+			free(child_name);
+		}
+		closedir(dir);
+		return ok;
+	}
+	if (!S_ISREG(info.st_mode))
+		return true;
+	if (name[0] == '\0' || strlen(name) > HUFFMAN_ARCHIVE_NAME_MAX)
+	{
+		huffman_error_set("Nom de membre invalide (%s).", path);
+		return false;
+	}
+	if (listing->count == listing->capacity)
+	{
+		size_t capacity = listing->capacity > 0 ? 2 * listing->capacity : 64;
+		file_t *files = realloc(listing->files, capacity * sizeof(file_t));
+		if (files == NULL)
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			return false;
+		}
+		listing->files = files;
+		listing->capacity = capacity;
+	}
+	file_t *file = &listing->files[listing->count];
+	file->path = strdup(path);
+	file->name = strdup(name);
+	if (file->path == NULL || file->name == NULL)
+	{
+		free(file->path);
+		free(file->name);
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	listing->count++;
+	return true;
+}
+
+/*
+ * prefix/name, ou name si prefix est vide. Le résultat est à libérer avec free().
+ */
+static char *join(const char *prefix, const char *name)
+{
+	size_t length = strlen(prefix);
+	char *path = malloc(length + strlen(name) + 2);
+	if (path == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	strcpy(path, prefix);
+	if (length > 0 && prefix[length - 1] != '/')
+		path[length++] = '/';
+	strcpy(path + length, name);
+	return path;
+}
+
+static int compare_files(const void *a, const void *b)
+{
+	return strcmp(((const file_t *)a)->name, ((const file_t *)b)->name);
+}
+
+static void free_listing(listing_t *listing)
+{
+	for (size_t i = 0; i < listing->count; i++)
+	{
+		free(listing->files[i].path);
+		free(listing->files[i].name);
+	}
+	free(listing->files);
+}
+
+/*
+ * Écrit l'entête, les trames dans l'ordre de l'index à mesure que les threads les terminent, puis l'index. Un membre
+ * qu'aucun thread n'a compressé en mémoire (tous avec un seul thread) est compressé par l'appelant directement dans
+ * l'archive, ses blocs par threads threads.
+ */
+static bool write_archive(pool_t *pool, unsigned threads, FILE *wfd)
+{
+	uint8_t buffer[HUFFMAN_WRITER_BUFFER_SIZE];
+	huffman_options_t options = pool->options;
+	huffman_writer_t writer;
+	pthread_t *ids = NULL;
+	unsigned started = 0;
+	bool ok = true;
+
+	options.threads = threads;
+	huffman_context_t *context = huffman_context_new(&options);
+	if (context != NULL && threads > 1 && (ids = calloc(threads, sizeof(pthread_t))) != NULL)
+	{
+		pthread_mutex_init(&pool->lock, NULL);
+		pthread_cond_init(&pool->changed, NULL);
+		ok = run(pool, threads, compress_work, ids, &started);
+	}
+	if (context == NULL || (threads > 1 && ids == NULL))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_context_free(context);
+		return false;
+	}
+
+	huffman_writer_init(&writer, buffer, sizeof(buffer), wfd);
+	for (const char *magic = HUFFMAN_ARCHIVE_MAGIC; *magic != '\0'; magic++)
+		huffman_writer_put(&writer, (uint8_t)*magic, 8);
+	huffman_writer_put(&writer, HUFFMAN_ARCHIVE_VERSION, 8);
+	for (size_t i = 0; ok && i < pool->count; i++)
+	{
+		member_t *member = &pool->members[i];
+		if (ids == NULL)
+		{
+			member->ok = true;
+		}
+		else
+		{
+			pthread_mutex_lock(&pool->lock);
+			while (!member->done)
+				pthread_cond_wait(&pool->changed, &pool->lock);
+			pthread_mutex_unlock(&pool->lock);
+		}
+		pool->entries[i].offset = huffman_writer_tell(&writer) / 8;
+		if (!member->ok)
+			huffman_error_set("%s", member->error != NULL ? member->error : "Allocation mémoire dynamique.");
+		if ((ok = member->ok) && member->data != NULL)
+			huffman_writer_bytes(&writer, member->data, member->length);
+		else if (ok)
+			ok = stream_member(context, &pool->listing->files[i], &pool->entries[i], member, &writer);
+		pool->entries[i].length = huffman_writer_tell(&writer) / 8 - pool->entries[i].offset;
+		free(member->data);
+		member->data = NULL;
+		ok = ok && !writer.failed;
+		if (ids != NULL)
+		{
+			pthread_mutex_lock(&pool->lock);
+			pool->written++;
+			pthread_cond_broadcast(&pool->changed);
+			pthread_mutex_unlock(&pool->lock);
+		}
+	}
+	if (ids != NULL)
+		stop(pool, ids, started);
+	huffman_context_free(context);
+	free(ids);
+	for (size_t i = 0; i < pool->count; i++)
+	{
+		free(pool->members[i].data);
+		free(pool->members[i].error);
+		close_member(&pool->members[i]);
+	}
+	if (!ok)
+	{
+		if (writer.failed)
+			huffman_error_set("%s", huffman_writer_error(&writer));
+		return false;
+	}
+
+	uint64_t index = huffman_writer_tell(&writer) / 8;
+	for (size_t i = 0; i < pool->count; i++)
+	{
+		const huffman_archive_entry_t *entry = &pool->entries[i];
+		const char *name = pool->listing->files[i].name;
+		size_t length = strlen(name);
+		huffman_writer_put(&writer, length, 16);
+		huffman_writer_bytes(&writer, (const uint8_t *)name, length);
+		huffman_writer_put(&writer, entry->offset, 64);
+		huffman_writer_put(&writer, entry->length, 64);
+		huffman_writer_put(&writer, entry->size, 64);
+		huffman_writer_put(&writer, entry->checksum, 32);
+	}
+	huffman_writer_put(&writer, index, 64);
+	huffman_writer_put(&writer, pool->count, 64);
+	for (const char *magic = HUFFMAN_ARCHIVE_MAGIC; *magic != '\0'; magic++)
+		huffman_writer_put(&writer, (uint8_t)*magic, 8);
+	if (!huffman_writer_finish(&writer))
+	{
+		huffman_error_set("%s", huffman_writer_error(&writer));
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Démarre threads threads sur work. Renvoie faux si aucun n'a pu être créé ; *started reçoit leur nombre.
+ */
+static bool run(pool_t *pool, unsigned threads, void *(*work)(void *), pthread_t *ids, unsigned *started)
+{
+	for (*started = 0; *started < threads; (*started)++)
+	{
+		if (pthread_create(&ids[*started], NULL, work, pool) != 0)
+			break;
+	}
+	if (*started == 0)
+	{
+		huffman_error_set("Création de thread.");
+		pool->failed = true;
+		pthread_cond_broadcast(&pool->changed);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Arrête les threads de la création : les membres qui n'ont pas été pris ne le seront plus.
+ */
+static void stop(pool_t *pool, pthread_t *ids, unsigned started)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->failed = true;
+	pthread_cond_broadcast(&pool->changed);
+	pthread_mutex_unlock(&pool->lock);
+	for (unsigned i = 0; i < started; i++)
+		pthread_join(ids[i], NULL);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->changed);
+}
+
+static void *compress_work(void *arg)
+{
+	pool_t *pool = arg;
+	huffman_context_t *context = huffman_context_new(&pool->options);
+
+	if (context == NULL)
+		huffman_error_set("Allocation mémoire dynamique.");
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->failed && pool->next < pool->count && pool->next - pool->written >= pool->window)
+			pthread_cond_wait(&pool->changed, &pool->lock);
+		if (pool->failed || pool->next == pool->count)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		size_t i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		bool ok = context != NULL &&
+		          compress_member(context, &pool->listing->files[i], &pool->entries[i], &pool->members[i]);
+		char *error = ok ? NULL : strdup(huffman_error());
+		pthread_mutex_lock(&pool->lock);
+		pool->members[i].ok = ok;
+		pool->members[i].error = error;
+		pool->members[i].done = true;
+		pthread_cond_broadcast(&pool->changed);
+		pthread_mutex_unlock(&pool->lock);
+	}
+	huffman_context_free(context);
+	return NULL;
+}
+
+/*
+ * Ouvre file et le projette en mémoire.
+ */
+static bool open_member(const file_t *file, member_t *member)
+{
+	if ((member->rfd = fopen(file->path, "rb")) == NULL)
+	{
+		huffman_error_set("Fichier %s introuvable.", file->path);
+		return false;
+	}
+	if (!huffman_input_open(&member->input, member->rfd))
+	{
+		huffman_error_set("Lecture du fichier %s.", file->path);
+		close_member(member);
+		return false;
+	}
+	return true;
+}
+
+static void close_member(member_t *member)
+{
+	if (member->rfd == NULL)
+		return;
+	huffman_input_close(&member->input);
+	fclose(member->rfd);
+	member->rfd = NULL;
+}
+
+/*
+ * Compresse file en une trame indépendante dans member->data : le contexte est remis à zéro, aucun bloc ne réutilise
+ * le codage du membre précédent. Un fichier de plus de options.block_size caractères reste ouvert dans member pour
+ * stream_member().
+ */
+static bool compress_member(huffman_context_t *context, const file_t *file, huffman_archive_entry_t *entry,
+                            member_t *member)
+{
+	if (!open_member(file, member))
+		return false;
+	if (member->input.size > context->options.block_size)
+		return true;
+	size_t capacity = huffman_compress_bound(&context->options, member->input.size);
+	huffman_status_t status = kHuffmanErrorMemory;
+	if ((member->data = malloc(capacity)) != NULL)
+	{
+		huffman_context_reset(context);
+		status = huffman_context_compress(context, member->input.data, member->input.size, member->data, capacity,
+		                                  &member->length);
+	}
+	entry->size = context->encoder.total;
+	entry->checksum = context->encoder.checksum;
+	close_member(member);
+	if (status != kHuffmanOk)
+	{
+		if (member->data == NULL)
+			huffman_error_set("Allocation mémoire dynamique.");
+		else
+			huffman_error_set("Compression du fichier %s : %s", file->path, huffman_error());
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Compresse file directement dans writer, bloc par bloc : ni le fichier ni sa trame ne sont copiés en mémoire. Le
+ * CRC-32C de la trame, calculé au fil de la compression, est celui du membre.
+ */
+static bool stream_member(huffman_context_t *context, const file_t *file, huffman_archive_entry_t *entry,
+                          member_t *member, huffman_writer_t *writer)
+{
+	if (member->rfd == NULL && !open_member(file, member))
+		return false;
+	huffman_context_reset(context);
+	bool ok = huffman_context_compress_input(context, &member->input, writer);
+	entry->size = context->encoder.total;
+	entry->checksum = context->encoder.checksum;
+	close_member(member);
+	if (!ok && !writer->failed)
+		huffman_error_set("Compression du fichier %s : %s", file->path, huffman_error());
+	return ok;
+}
+
+static void *extract_work(void *arg)
+{
+	pool_t *pool = arg;
+	huffman_context_t *context = huffman_context_new(&pool->options);
+
+	if (context == NULL)
+		huffman_error_set("Allocation mémoire dynamique.");
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->lock);
+		if (context == NULL)
+			fail(pool);
+		if (pool->failed || pool->next == pool->count)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		size_t i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (!extract_file(pool->archive, &pool->archive->entries[i], context, pool->directory))
+		{
+			pthread_mutex_lock(&pool->lock);
+			fail(pool);
+			pthread_mutex_unlock(&pool->lock);
+		}
+	}
+	huffman_context_free(context);
+	return NULL;
+}
+
+/*
+ * Appelée avec pool->lock : le message du premier thread d'extraction qui échoue est gardé pour l'appelant.
+ */
+static void fail(pool_t *pool)
+{
+	if (!pool->failed)
+		strcpy(pool->error, huffman_error());
+	pool->failed = true;
+}
+
+static bool extract_file(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                         huffman_context_t *context, const char *directory)
+{
+	char *path = join(directory, entry->name);
+	if (path == NULL)
+		return false;
+	if (!make_parents(path))
+	{
+		huffman_error_set("Impossible de créer le répertoire de %s.", path);
+		free(path);
+		return false;
+	}
+	FILE *wfd = fopen(path, "wb");
+	if (wfd == NULL)
+	{
+		huffman_error_set("Impossible de créer le fichier %s.", path);
+		free(path);
+		return false;
+	}
+	bool ok = extract_member(archive, entry, context, wfd);
+	if (fclose(wfd) != 0 && ok)
+	{
+		huffman_error_set("Lors de l'écriture (fwrite).");
+		ok = false;
+	}
+	if (!ok)
+		remove(path);
+	free(path);
+	return ok;
+}
+
+/*
+ * La trame est lue dans l'archive avec pread() et décodée par tranches directement dans wfd : ni la trame ni le membre
+ * ne sont entiers en mémoire. Le CRC-32C de chaque bloc et de la trame est vérifié au fil du décodage, puis la taille et
+ * le CRC de la trame sont comparés à ceux de l'index. Un membre corrompu peut avoir été écrit en partie.
+ */
+static bool extract_member(const huffman_archive_t *archive, const huffman_archive_entry_t *entry,
+                           huffman_context_t *context, FILE *wfd)
+{
+	huffman_context_reset(context);
+	bool ok = huffman_context_decompress_range(context, archive->rfd, entry->offset, entry->length, write_file, wfd);
+	if (!ok && !context->writer.failed)
+	{
+		huffman_error_set("Membre %s corrompu : %s", entry->name, huffman_error());
+	}
+	else if (ok && (context->state.file_size != entry->size || context->decoder.checksum != entry->checksum))
+	{
+		huffman_error_set("Membre %s corrompu.", entry->name);
+		ok = false;
+	}
+	return ok;
+}
+
+static bool write_file(void *opaque, const uint8_t *data, size_t size)
+{
+	return fwrite(data, 1, size, opaque) == size;
+}
+
+static uint64_t get64(huffman_reader_t *reader)
+{
+	uint64_t high = huffman_reader_get(reader, 32);
+	return high << 32 | huffman_reader_get(reader, 32);
+}
+
+/*
+ * Un nom de membre est un chemin relatif sans composant vide, "." ni "..", pour que l'extraction reste sous le
+ * répertoire choisi.
+ */
+static bool valid_name(const char *name)
+{
+	if (name[0] == '\0')
+		return false;
+	for (const char *part = name; part != NULL;)
+	{
+		const char *slash = strchr(part, '/');
+		size_t length = slash != NULL ? (size_t)(slash - part) : strlen(part);
+		if (length == 0 || (length == 1 && part[0] == '.') || (length == 2 && part[0] == '.' && part[1] == '.'))
+			return false;
+		part = slash != NULL ? slash + 1 : NULL;
+	}
+	return true;
+}
+
+/*
+ * Crée les répertoires de path jusqu'à son dernier '/'.
+ */
+static bool make_parents(char *path)
+{
+	for (char *slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+	{
+		*slash = '\0';
+		bool ok = mkdir(path, 0777) == 0 || errno == EEXIST;
+		*slash = '/';
+		if (!ok)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,530 @@
+#include "huffman/block.h"
+#include "huffman/build.h"
+#include "huffman/checksum.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/header.h"
+#include "huffman/histogram.h"
+#include "huffman/stats.h"
+#include <string.h>
+
+/*
+ * Codage déjà connu du décodeur, qu'un bloc peut réutiliser au lieu d'écrire le sien.
+ */
+typedef struct reuse
+{
+	const uint8_t *lengths; /*!< \brief Longueur du codage de chaque caractère, ou NULL. */
+	uint8_t type;           /*!< \brief kHuffmanBlockRepeat ou kHuffmanBlockDictionary. */
+	uint32_t header;        /*!< \brief Taille de l'entête du bloc avant les caractères codés. */
+	uint32_t dictionary;    /*!< \brief Identifiant du dictionnaire. */
+	uint64_t bits;          /*!< \brief Nombre de bits du bloc avec ce codage. */
+	bool close;             /*!< \brief Le bloc coûte à peu près ce que coûtaient les caractères d'origine. */
+} reuse_t;
+
+static void choose_reuse(reuse_t *reuse, const uint64_t count[CHAR_COUNT], size_t size,
+                         const huffman_options_t *options, const huffman_frame_t *frame);
+static bool code_cost(const uint8_t lengths[CHAR_COUNT], const uint64_t count[CHAR_COUNT], uint64_t *bits);
+static void reuse_block(huffman_block_t *block, const reuse_t *reuse, size_t size);
+static void interleave(huffman_block_t *block, const uint8_t *data, size_t size, unsigned streams);
+static bool choose_model(huffman_block_t *block, const uint8_t *data, size_t size, const huffman_options_t *options);
+static void raw_block(huffman_block_t *block, uint8_t type, size_t size);
+static void finish_block(huffman_block_t *block, uint32_t checksum, const uint64_t count[CHAR_COUNT]);
+static void record_block(const huffman_block_t *block, const uint64_t count[CHAR_COUNT]);
+
+void huffman_frame_init(huffman_frame_t *frame)
+{
+	memset(frame, 0, sizeof(huffman_frame_t));
+}
+
+/*
+ * Construit l'arbre et les codages du bloc. Avec options->max_code_length non nul, les codages sont canoniques et
+ * limités à max_code_length bits ; sinon ce sont ceux de l'arbre, écrit en entier. La taille du bloc compressé est
+ * connue avant l'encodage : chaque caractère c coûte code[c].length bits.
+ *
+ * Le dernier codage canonique de frame (qui peut être NULL) ou le dictionnaire des options peuvent être réutilisés.
+ * Ils le sont sans construire d'arbre si le bloc ne coûte pas plus de 1/16 de bits par caractère de plus qu'avec les
+ * caractères pour lesquels ils ont été construits, et sinon s'ils restent plus courts que le nouvel entête et le
+ * nouveau codage réunis.
+ *
+ * Avec options->contexts et block->model, un modèle d'ordre 1 remplace ce codage s'il rend le bloc plus court ; sinon,
+ * avec options->streams > 1, les caractères sont ensuite répartis entre plusieurs flux.
+ *
+ * Un bloc d'un seul caractère différent devient un bloc kHuffmanBlockRun, sans construire d'arbre, et un bloc que le
+ * codage choisi ne raccourcit pas un bloc kHuffmanBlockStored : aucun bloc n'est plus long que ses caractères.
+ * Chaque bloc se termine par le CRC-32C de ses caractères, calculé pendant le comptage.
+ */
+bool huffman_block_prepare(huffman_state_t *state, huffman_block_t *block, const uint8_t *data, size_t size,
+                           const huffman_options_t *options, const huffman_frame_t *frame)
+{
+	uint64_t count[CHAR_COUNT] = {0};
+	uint64_t bits = 0;
+	uint32_t header;
+	reuse_t reuse;
+
+	HUFFMAN_STATS_START(start);
+	uint32_t checksum = huffman_histogram_crc32c(count, 0, data, size);
+	HUFFMAN_STATS_STOP(kHuffmanStageHistogram, start);
+	if (count[data[0]] == size)
+	{
+		raw_block(block, kHuffmanBlockRun, size);
+		finish_block(block, checksum, count);
+		return true;
+	}
+	choose_reuse(&reuse, count, size, options, frame);
+	if (reuse.lengths != NULL && reuse.close)
+	{
+		reuse_block(block, &reuse, size);
+		if (!choose_model(block, data, size, options))
+			interleave(block, data, size, options->streams);
+		if (block->length >= size)
+			raw_block(block, kHuffmanBlockStored, size);
+		finish_block(block, checksum, count);
+		return true;
+	}
+
+	huffman_state_init(state);
+	state->file_size = size;
+	huffman_set_frequencies(state, count);
+	if (!huffman_build(state))
+		return false;
+	HUFFMAN_STATS_START(code);
+	if (options->max_code_length != 0)
+	{
+		uint8_t length[CHAR_COUNT];
+		uint16_t first = CHAR_COUNT - 1;
+		uint16_t last = 0;
+		huffman_code_lengths(length, state, options->max_code_length);
+		huffman_canonical_code(block->code, length);
+		for (uint16_t i = 0; i < state->num_leaves; i++)
+		{
+			first = state->leaves[i] < first ? state->leaves[i] : first;
+			last = state->leaves[i] > last ? state->leaves[i] : last;
+		}
+		block->type = kHuffmanBlockCanonical;
+		header = 2 + (last - first + 2) / 2;
+	}
+	else
+	{
+		if (!huffman_calculate_code(block->code, &state->tree))
+			return false;
+		block->type = kHuffmanBlockTree;
+		header = 2 + state->num_leaves + (2 * state->num_leaves - 1 + 7) / 8;
+	}
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+		bits += count[state->leaves[i]] * block->code[state->leaves[i]].length;
+	HUFFMAN_STATS_STOP(kHuffmanStageCode, code);
+
+	if (reuse.lengths != NULL && reuse.header + (reuse.bits + 7) / 8 <= header + (bits + 7) / 8)
+	{
+		reuse_block(block, &reuse, size);
+	}
+	else
+	{
+		block->size = size;
+		block->bits = bits;
+		block->length = header + (bits + 7) / 8;
+	}
+	if (!choose_model(block, data, size, options))
+		interleave(block, data, size, options->streams);
+	if (block->length >= size)
+		raw_block(block, kHuffmanBlockStored, size);
+	finish_block(block, checksum, count);
+	return true;
+}
+
+/*
+ * Un bloc kHuffmanBlockStored contient ses size caractères, un bloc kHuffmanBlockRun son seul caractère. Leurs
+ * caractères ne sont pas codés : block->code ne code aucun caractère.
+ */
+static void raw_block(huffman_block_t *block, uint8_t type, size_t size)
+{
+	memset(block->code, 0, sizeof(block->code));
+	block->type = type;
+	block->size = size;
+	block->length = type == kHuffmanBlockStored ? size : 1;
+	block->bits = (uint64_t)block->length * 8;
+	block->streams = 1;
+}
+
+/*
+ * checksum est le CRC-32C des caractères, renvoyé par huffman_histogram_crc32c().
+ */
+static void finish_block(huffman_block_t *block, uint32_t checksum, const uint64_t count[CHAR_COUNT])
+{
+	block->has_checksum = true;
+	block->checksum = checksum;
+	block->length += HUFFMAN_BLOCK_CHECKSUM_SIZE;
+	record_block(block, count);
+}
+
+/*
+ * Les codages d'un modèle d'ordre 1 sont canoniques, limités à HUFFMAN_CODE_LENGTH_MAX bits même si le reste de la
+ * trame écrit des arbres complets. Ses caractères ne sont pas entrelacés : chacun dépend du précédent.
+ */
+static bool choose_model(huffman_block_t *block, const uint8_t *data, size_t size, const huffman_options_t *options)
+{
+	uint8_t max_length = options->max_code_length != 0 ? options->max_code_length : HUFFMAN_CODE_LENGTH_MAX;
+	uint64_t bits;
+	uint32_t header;
+
+	if (options->contexts == 0 || block->model == NULL)
+		return false;
+	huffman_model_prepare(block->model, data, size, options->contexts, max_length, &bits, &header);
+	if (header + (bits + 7) / 8 >= block->length)
+		return false;
+	block->type = kHuffmanBlockContext;
+	block->bits = bits;
+	block->length = header + (bits + 7) / 8;
+	block->streams = 1;
+	return true;
+}
+
+/*
+ * Le caractère i va dans le flux i % streams, si chaque flux reçoit au moins HUFFMAN_STREAM_SIZE_MIN caractères. La
+ * taille de chaque flux doit être écrite avant les flux : elle est calculée ici avec les codages du bloc.
+ */
+static void interleave(huffman_block_t *block, const uint8_t *data, size_t size, unsigned streams)
+{
+	uint64_t bits[HUFFMAN_STREAMS_MAX] = {0};
+
+	block->streams = 1;
+	if (streams < 2 || size < (size_t)streams * HUFFMAN_STREAM_SIZE_MIN)
+		return;
+	for (size_t i = 0; i < size;)
+		for (unsigned j = 0; j < streams && i < size; j++, i++)
+			bits[j] += block->code[data[i]].length;
+	block->streams = streams;
+	block->length -= (block->bits + 7) / 8;
+	block->length += 1 + 4 * streams;
+	for (unsigned j = 0; j < streams; j++)
+	{
+		block->stream_sizes[j] = (bits[j] + 7) / 8;
+		block->length += block->stream_sizes[j];
+	}
+}
+
+/*
+ * Nombre de caractères différents et plus long codage du bloc, pour huffman_stats_t.
+ */
+static void record_block(const huffman_block_t *block, const uint64_t count[CHAR_COUNT])
+{
+#ifdef HUFFMAN_STATS
+	uint16_t symbols = 0;
+	uint8_t length = 0;
+
+	if (huffman_stats_current == NULL)
+		return;
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		if (count[c] == 0)
+			continue;
+		symbols++;
+		length = block->code[c].length > length ? block->code[c].length : length;
+	}
+	HUFFMAN_STATS_MAX(symbols, symbols);
+	HUFFMAN_STATS_MAX(max_code_length, length);
+#else
+	(void)block;
+	(void)count;
+#endif
+}
+
+/*
+ * Garde le moins coûteux du codage de frame et de celui du dictionnaire, s'ils codent tous les caractères présents. Le
+ * codage de frame est comparé au dernier bloc construit avec lui, le dictionnaire à ses échantillons.
+ */
+static void choose_reuse(reuse_t *reuse, const uint64_t count[CHAR_COUNT], size_t size,
+                         const huffman_options_t *options, const huffman_frame_t *frame)
+{
+	const huffman_dictionary_t *dictionary = options->dictionary;
+	uint64_t bits = 0;
+
+	reuse->lengths = NULL;
+	if (frame != NULL && frame->has_code && code_cost(frame->lengths, count, &bits))
+	{
+		*reuse = (reuse_t){.lengths = frame->lengths, .type = kHuffmanBlockRepeat, .header = 0, .bits = bits};
+		reuse->close = bits * frame->size * 16 <= frame->bits * size * 17;
+	}
+	bits = 0;
+	if (dictionary != NULL && code_cost(dictionary->lengths, count, &bits) &&
+	    (reuse->lengths == NULL || 4 + (bits + 7) / 8 < (reuse->bits + 7) / 8))
+	{
+		*reuse = (reuse_t){.lengths = dictionary->lengths, .type = kHuffmanBlockDictionary, .header = 4,
+		                   .dictionary = dictionary->id, .bits = bits};
+		reuse->close = bits * HUFFMAN_DICTIONARY_RATE_ONE * 16 <= (uint64_t)dictionary->rate * size * 17;
+	}
+}
+
+/*
+ * Nombre de bits des caractères de count avec le codage lengths, s'il code tous les caractères présents.
+ */
+static bool code_cost(const uint8_t lengths[CHAR_COUNT], const uint64_t count[CHAR_COUNT], uint64_t *bits)
+{
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		if (count[c] != 0 && lengths[c] == 0)
+			return false;
+		*bits += count[c] * lengths[c];
+	}
+	return true;
+}
+
+static void reuse_block(huffman_block_t *block, const reuse_t *reuse, size_t size)
+{
+	huffman_canonical_code(block->code, reuse->lengths);
+	block->type = reuse->type;
+	block->dictionary = reuse->dictionary;
+	block->size = size;
+	block->bits = reuse->bits;
+	block->length = reuse->header + (reuse->bits + 7) / 8;
+}
+
+/*
+ * Met à jour la trame après l'écriture de block. Un bloc répété garde la référence du bloc canonique
+ * dont il reprend le codage, pour que l'écart toléré ne s'accumule pas d'un bloc à l'autre. Un bloc d'ordre 1 ne
+ * change pas ce codage.
+ */
+void huffman_block_commit(huffman_frame_t *frame, const huffman_block_t *block)
+{
+	frame->total += block->size;
+	frame->blocks++;
+	frame->checksum = huffman_crc32c_combine(frame->checksum, block->checksum, block->size);
+	frame->coded += block->bits;
+	if (block->type == kHuffmanBlockCanonical || block->type == kHuffmanBlockDictionary)
+	{
+		for (uint16_t c = 0; c < CHAR_COUNT; c++)
+			frame->lengths[c] = block->code[c].length;
+		frame->has_code = true;
+		frame->size = block->size;
+		frame->bits = block->bits;
+	}
+	else if (block->type == kHuffmanBlockTree)
+	{
+		frame->has_code = false;
+	}
+}
+
+void huffman_block_write(const huffman_state_t *state, const huffman_block_t *block, huffman_writer_t *writer,
+                         const uint8_t *data)
+{
+	HUFFMAN_STATS_START(start);
+	uint8_t type = block->type | (block->has_checksum ? HUFFMAN_BLOCK_CHECKSUM : 0);
+	huffman_writer_put(writer, type | (block->streams > 1 ? HUFFMAN_BLOCK_INTERLEAVED : 0), 8);
+	huffman_writer_put(writer, block->size, 32);
+	huffman_writer_put(writer, block->length, 32);
+	if (block->type == kHuffmanBlockCanonical)
+	{
+		huffman_write_lengths(writer, state, block->code);
+	}
+	else if (block->type == kHuffmanBlockDictionary)
+	{
+		huffman_writer_put(writer, block->dictionary, 32);
+	}
+	else if (block->type == kHuffmanBlockTree)
+	{
+		huffman_writer_put(writer, state->num_leaves / CHAR_COUNT, 8);
+		huffman_writer_put(writer, state->num_leaves - state->num_leaves / CHAR_COUNT, 8);
+		huffman_write_header(writer, &state->tree);
+		huffman_write_tree(writer, &state->tree);
+	}
+	if (block->type == kHuffmanBlockStored)
+	{
+		huffman_writer_bytes(writer, data, block->size);
+	}
+	else if (block->type == kHuffmanBlockRun)
+	{
+		huffman_writer_put(writer, data[0], 8);
+	}
+	else if (block->type == kHuffmanBlockContext)
+	{
+		huffman_model_write(block->model, writer, data, block->size);
+	}
+	else if (block->streams > 1)
+	{
+		huffman_writer_put(writer, block->streams, 8);
+		for (uint8_t j = 0; j < block->streams; j++)
+			huffman_writer_put(writer, block->stream_sizes[j], 32);
+		for (uint8_t j = 0; j < block->streams; j++)
+		{
+			for (size_t i = j; i < block->size; i += block->streams)
+				huffman_writer_put(writer, block->code[data[i]].bits, block->code[data[i]].length);
+			huffman_writer_align(writer);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < block->size; i++)
+			huffman_writer_put(writer, block->code[data[i]].bits, block->code[data[i]].length);
+		huffman_writer_align(writer);
+	}
+	if (block->has_checksum)
+		huffman_writer_put(writer, block->checksum, 32);
+	HUFFMAN_STATS_STOP(kHuffmanStageWrite, start);
+}
+
+/*
+ * Lit l'entête d'un bloc. block->size vaut 0 pour le bloc de fin. block->streams vaut 0 pour un bloc entrelacé : sa
+ * table des flux est lue par huffman_block_read_streams() après l'entête de codage. Un bloc kHuffmanBlockContext
+ * n'est jamais entrelacé ; son modèle est lu par huffman_model_read(). Les blocs kHuffmanBlockStored et
+ * kHuffmanBlockRun ne le sont pas non plus, et leur taille est celle de leurs caractères ou de leur seul caractère,
+ * plus celle de la somme de contrôle si le bloc en a une (huffman_block_check()).
+ */
+bool huffman_block_read_header(huffman_reader_t *reader, huffman_block_t *block, uint32_t block_size)
+{
+	uint8_t type = huffman_reader_get(reader, 8);
+	block->size = 0;
+	block->length = 0;
+	if (huffman_reader_truncated(reader))
+	{
+		huffman_error_set("Fichier tronqué.");
+		return false;
+	}
+	if (type == kHuffmanBlockEnd)
+		return true;
+	block->streams = type & HUFFMAN_BLOCK_INTERLEAVED ? 0 : 1;
+	block->has_checksum = type & HUFFMAN_BLOCK_CHECKSUM;
+	block->type = type & ~(HUFFMAN_BLOCK_INTERLEAVED | HUFFMAN_BLOCK_CHECKSUM);
+	if (block->type < kHuffmanBlockTree || block->type > kHuffmanBlockRun ||
+	    (block->type >= kHuffmanBlockContext && block->streams != 1))
+	{
+		huffman_error_set("Type de bloc inconnu (%d).", type);
+		return false;
+	}
+	block->size = huffman_reader_get(reader, 32);
+	block->length = huffman_reader_get(reader, 32);
+	uint32_t checksum = block->has_checksum ? HUFFMAN_BLOCK_CHECKSUM_SIZE : 0;
+	if (block->size == 0 || block->size > block_size || block->length > HUFFMAN_BLOCK_LENGTH_MAX(block->size) ||
+	    block->length < checksum ||
+	    (block->type == kHuffmanBlockStored && block->length != block->size + checksum) ||
+	    (block->type == kHuffmanBlockRun && block->length != 1 + checksum))
+	{
+		huffman_error_set("Taille de bloc invalide (%u).", block->size);
+		return false;
+	}
+	HUFFMAN_STATS_ADD(blocks, 1);
+	HUFFMAN_STATS_ADD(bytes_in, HUFFMAN_BLOCK_HEADER_SIZE + block->length);
+	HUFFMAN_STATS_ADD(bytes_out, block->size);
+	return true;
+}
+
+/*
+ * Lit la somme de contrôle qui termine block, après ses caractères codés, et la compare au CRC-32C checksum de ses
+ * caractères décodés. Ces caractères sont ensuite ajoutés au CRC de frame, s'il n'est pas NULL. Un bloc sans somme de
+ * contrôle n'est pas vérifié.
+ */
+bool huffman_block_check(huffman_reader_t *reader, const huffman_block_t *block, uint32_t checksum,
+                         huffman_frame_t *frame)
+{
+	if (block->has_checksum)
+	{
+		huffman_reader_align(reader);
+		uint32_t expected = huffman_reader_get(reader, 32);
+		if (huffman_reader_truncated(reader))
+		{
+			huffman_error_set("Fichier tronqué.");
+			return false;
+		}
+		if (expected != checksum)
+		{
+			huffman_error_set("Somme de contrôle du bloc invalide (%08x au lieu de %08x).",
+			        checksum, expected);
+			return false;
+		}
+	}
+	if (frame != NULL)
+		frame->checksum = huffman_crc32c_combine(frame->checksum, checksum, block->size);
+	return true;
+}
+
+/*
+ * Lit l'identifiant d'un bloc kHuffmanBlockDictionary, qui doit être celui de dictionary. Le codage du dictionnaire
+ * devient celui que les blocs répétés suivants réutilisent.
+ */
+const huffman_dictionary_t *huffman_block_read_dictionary(huffman_reader_t *reader,
+                                                          const huffman_dictionary_t *dictionary,
+                                                          huffman_frame_t *frame)
+{
+	uint32_t id = huffman_reader_get(reader, 32);
+	if (dictionary == NULL || dictionary->id != id)
+	{
+		huffman_error_set("Dictionnaire %u inconnu.", id);
+		return NULL;
+	}
+	memcpy(frame->lengths, dictionary->lengths, CHAR_COUNT);
+	frame->has_code = true;
+	return dictionary;
+}
+
+/*
+ * Lit l'entête d'arbre ou de longueurs qui suit l'entête du bloc. Les longueurs lues sont gardées dans frame pour les
+ * blocs répétés suivants ; un bloc répété reconstruit l'arbre à partir de frame (qui peut être NULL sinon).
+ */
+bool huffman_block_read_code(huffman_reader_t *reader, const huffman_block_t *block, huffman_state_t *state,
+                             huffman_frame_t *frame)
+{
+	uint8_t length[CHAR_COUNT];
+
+	if (block->type == kHuffmanBlockTree)
+	{
+		if (frame != NULL)
+			frame->has_code = false;
+		return huffman_read_header(reader, state);
+	}
+	if (block->type == kHuffmanBlockRepeat)
+	{
+		if (frame == NULL || !frame->has_code)
+		{
+			huffman_error_set("Bloc répété sans codage précédent.");
+			return false;
+		}
+		return huffman_build_canonical(state, frame->lengths);
+	}
+	uint8_t *lengths = frame != NULL ? frame->lengths : length;
+	if (!huffman_read_lengths(reader, lengths) || !huffman_build_canonical(state, lengths))
+	{
+		if (frame != NULL)
+			frame->has_code = false;
+		return false;
+	}
+	if (frame != NULL)
+		frame->has_code = true;
+	return true;
+}
+
+/*
+ * Lit la table des flux d'un bloc entrelacé et prépare un lecteur par flux. Les flux sont lus directement dans
+ * l'entrée si elle est en mémoire, sinon copiés dans scratch, qui doit alors contenir block->length octets.
+ */
+bool huffman_block_read_streams(huffman_reader_t *reader, const huffman_block_t *block, huffman_streams_t *streams,
+                                uint8_t *scratch)
+{
+	uint32_t sizes[HUFFMAN_STREAMS_MAX];
+	uint64_t total = 0;
+
+	streams->count = huffman_reader_get(reader, 8);
+	streams->next = 0;
+	if (streams->count < 2 || streams->count > HUFFMAN_STREAMS_MAX)
+	{
+		huffman_error_set("Nombre de flux invalide (%d).", streams->count);
+		return false;
+	}
+	for (uint8_t j = 0; j < streams->count; j++)
+	{
+		sizes[j] = huffman_reader_get(reader, 32);
+		total += sizes[j];
+	}
+	const uint8_t *data = NULL;
+	if (total <= block->length)
+		data = huffman_reader_take(reader, total, scratch);
+	if (data == NULL)
+	{
+		huffman_error_set("Table des flux invalide.");
+		return false;
+	}
+	for (uint8_t j = 0; j < streams->count; j++)
+	{
+		huffman_reader_init_memory(&streams->readers[j], data, sizes[j]);
+		data += sizes[j];
+	}
+	return true;
+}
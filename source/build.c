@@ -1,72 +1,80 @@
 #include "huffman/build.h"
 #include "huffman/node.h"
 #include "huffman/sort.h"
-#include <stdio.h>
+#include "huffman/stats.h"
 
+/*
+ * Copie les fréquences dans les feuilles et remplit state->leaves. Les fréquences des noeuds sont sur 32 bits : si la
+ * somme dépasse UINT32_MAX, toutes les fréquences sont divisées par la même puissance de 2, sans descendre sous 1.
+ * L'arbre obtenu reste très proche de l'optimal.
+ */
+void huffman_set_frequencies(huffman_state_t *state, const uint64_t count[CHAR_COUNT])
+{
+	uint64_t total = 0;
+	uint8_t shift = 0;
+
+	HUFFMAN_STATS_START(start);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		total += count[c];
+	while ((total >> shift) > UINT32_MAX - CHAR_COUNT)
+		shift++;
+	state->num_leaves = 0;
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		uint64_t freq = count[c] >> shift;
+		state->tree.nodes[c].freq = freq == 0 && count[c] != 0 ? 1 : freq;
+		if (count[c] != 0)
+			state->leaves[state->num_leaves++] = c;
+	}
+	HUFFMAN_STATS_STOP(kHuffmanStageBuild, start);
+}
+
+/*
+ * Fusion de deux files à la manière de Moffat et Katajainen : les feuilles triées forment la première file, les noeuds
+ * internes, créés par poids croissant, la seconde. Les deux files partagent le tableau freq : le poids du noeud next
+ * remplace la fréquence d'une feuille déjà prise, puisqu'au moins next + 2 feuilles ont été prises quand il est créé.
+ * Le noeud next est rangé en CHAR_COUNT + next ; à poids égal, la feuille passe avant le noeud.
+ */
 bool huffman_build(huffman_state_t *state)
 {
+	huffman_node_t *nodes = state->tree.nodes;
+	uint32_t freq[CHAR_COUNT];
+	uint16_t leaf = 0;
+	uint16_t node = 0;
+
 	if (state->num_leaves == 0)
-	{
-		fprintf(stderr, "\nFichier vide.\n\n");
 		return false;
-	}
 	else if (state->num_leaves == 1)
 	{
 		state->tree.root = state->leaves[0];
 		return true;
 	}
-	huffman_heapsort(state, state->leaves, state->num_leaves - 1);
-	huffman_node_t *root = &state->tree.nodes[state->tree.root];
-	root->freq = state->tree.nodes[state->leaves[0]].freq + state->tree.nodes[state->leaves[1]].freq;
-	root->type = kHuffmanNodeNode;
-	root->u.node.left_child = state->leaves[0];
-	root->u.node.right_child = state->leaves[1];
-	state->tree.nodes[state->leaves[0]].parent = state->tree.root;
-	state->tree.nodes[state->leaves[1]].parent = state->tree.root;
-
-	uint16_t small_leaf = 2;
-	uint16_t small_node = state->tree.root;
-	state->tree.root++;
-
-	while (state->tree.root < CHAR_COUNT + state->num_leaves - 1)
+	HUFFMAN_STATS_START(sort);
+	huffman_sort_leaves(state, freq);
+	HUFFMAN_STATS_STOP(kHuffmanStageSort, sort);
+	HUFFMAN_STATS_START(start);
+	for (uint16_t next = 0; next < state->num_leaves - 1; next++)
 	{
-		root = &state->tree.nodes[state->tree.root];
-		if (small_leaf < state->num_leaves &&
-		    state->tree.nodes[state->leaves[small_leaf]].freq <= state->tree.nodes[small_node].freq)
-		{
-			root->freq = state->tree.nodes[state->leaves[small_leaf]].freq;
-			root->type = kHuffmanNodeNode;
-			root->u.node.left_child = state->leaves[small_leaf];
-			state->tree.nodes[state->leaves[small_leaf]].parent = state->tree.root;
-			small_leaf++;
-		}
-		else
-		{
-			root->freq = state->tree.nodes[small_node].freq;
-			root->type = kHuffmanNodeNode;
-			root->u.node.left_child = small_node;
-			state->tree.nodes[small_node].parent = state->tree.root;
-			small_node++;
-		}
-		if (small_node >= state->tree.root ||
-		    (small_leaf < state->num_leaves &&
-		     state->tree.nodes[state->leaves[small_leaf]].freq <= state->tree.nodes[small_node].freq))
-		{
-			root->freq += state->tree.nodes[state->leaves[small_leaf]].freq;
-			root->type = kHuffmanNodeNode;
-			root->u.node.right_child = state->leaves[small_leaf];
-			state->tree.nodes[state->leaves[small_leaf]].parent = state->tree.root;
-			small_leaf++;
-		}
-		else
+		uint16_t child[2];
+		uint32_t weight = 0;
+		for (uint8_t k = 0; k < 2; k++)
 		{
-			root->freq += state->tree.nodes[small_node].freq;
-			root->u.node.right_child = small_node;
-			state->tree.nodes[small_node].parent = state->tree.root;
-			small_node++;
+			if (leaf < state->num_leaves && (node >= next || freq[leaf] <= freq[node]))
+			{
+				weight += freq[leaf];
+				child[k] = state->leaves[leaf++];
+			}
+			else
+			{
+				weight += freq[node];
+				child[k] = CHAR_COUNT + node++;
+			}
+			nodes[child[k]].parent = CHAR_COUNT + next;
 		}
-		root++;
+		freq[next] = weight;
+		huffman_node_init_node(&nodes[CHAR_COUNT + next], child[0], child[1], weight, HUFFMAN_NODE_NONE);
 	}
-	root--;
+	state->tree.root = CHAR_COUNT + state->num_leaves - 2;
+	HUFFMAN_STATS_STOP(kHuffmanStageBuild, start);
 	return true;
 }
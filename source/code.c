@@ -0,0 +1,121 @@
+#include "huffman/code.h"
+#include "huffman/error.h"
+
+/*
+ * Parcours préfixe de l'arbre avec une pile : on ajoute 0 en allant à gauche et 1 en allant à droite. Une racine
+ * seule (une seule feuille) reçoit le codage "0" sur un bit.
+ */
+bool huffman_calculate_code(huffman_code_t code[CHAR_COUNT], const huffman_tree_t *tree)
+{
+	uint16_t stack[CHAR_COUNT];
+	huffman_code_t path[CHAR_COUNT];
+	uint16_t depth = 0;
+
+	if (tree->nodes[tree->root].type == kHuffmanNodeLeaf)
+	{
+		code[tree->nodes[tree->root].u.leaf.c] = (huffman_code_t){.bits = 0, .length = 1};
+		return true;
+	}
+	stack[depth] = tree->root;
+	path[depth++] = (huffman_code_t){.bits = 0, .length = 0};
+	while (depth > 0)
+	{
+		const huffman_node_t *node = &tree->nodes[stack[--depth]];
+		huffman_code_t current = path[depth];
+		if (node->type == kHuffmanNodeLeaf)
+		{
+			code[node->u.leaf.c] = current;
+			continue;
+		}
+		if (current.length == 64)
+		{
+			huffman_error_set("Codage de plus de 64 bits.");
+			return false;
+		}
+		stack[depth] = node->u.node.right_child;
+		path[depth++] = (huffman_code_t){.bits = current.bits << 1 | 1, .length = current.length + 1};
+		stack[depth] = node->u.node.left_child;
+		path[depth++] = (huffman_code_t){.bits = current.bits << 1, .length = current.length + 1};
+	}
+	return true;
+}
+
+/*
+ * Longueur du codage de chaque caractère (0 s'il est absent), d'au plus max_length bits. Les feuilles plus profondes
+ * sont remontées à max_length, puis l'inégalité de Kraft est rétablie en allongeant le codage des caractères les moins
+ * fréquents ; la place laissée libre est rendue aux plus fréquents. state->leaves est trié par fréquence croissante
+ * par huffman_build().
+ */
+void huffman_code_lengths(uint8_t length[CHAR_COUNT], const huffman_state_t *state, uint8_t max_length)
+{
+	const huffman_node_t *nodes = state->tree.nodes;
+	uint32_t kraft = 0;
+	uint32_t capacity = (uint32_t)1 << max_length;
+
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		length[c] = 0;
+	if (state->num_leaves == 1)
+	{
+		length[state->leaves[0]] = 1;
+		return;
+	}
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+	{
+		uint16_t c = state->leaves[i];
+		uint16_t depth = 0;
+		for (uint16_t node = c; nodes[node].parent != HUFFMAN_NODE_NONE; node = nodes[node].parent)
+			depth++;
+		length[c] = depth < max_length ? depth : max_length;
+		kraft += capacity >> length[c];
+	}
+
+	/* Chaque allongement d'un codage de l bits libère capacity >> (l + 1). */
+	while (kraft > capacity)
+	{
+		uint16_t best = CHAR_COUNT;
+		for (uint16_t i = 0; i < state->num_leaves; i++)
+		{
+			uint16_t c = state->leaves[i];
+			if (length[c] < max_length && (best == CHAR_COUNT || length[c] > length[best]))
+				best = c;
+		}
+		kraft -= capacity >> (length[best] + 1);
+		length[best]++;
+	}
+	for (uint16_t i = state->num_leaves; i-- > 0;)
+	{
+		uint16_t c = state->leaves[i];
+		while (length[c] > 1 && kraft + (capacity >> length[c]) <= capacity)
+		{
+			kraft += capacity >> length[c];
+			length[c]--;
+		}
+	}
+}
+
+/*
+ * Codage canonique : les caractères sont numérotés par longueur croissante puis par valeur croissante. Les longueurs
+ * suffisent donc à retrouver les codages. Un caractère absent reçoit un codage de longueur 0.
+ */
+void huffman_canonical_code(huffman_code_t code[CHAR_COUNT], const uint8_t length[CHAR_COUNT])
+{
+	uint16_t count[HUFFMAN_CODE_LENGTH_MAX + 1] = {0};
+	uint32_t next[HUFFMAN_CODE_LENGTH_MAX + 1];
+	uint32_t value = 0;
+
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		count[length[c]]++;
+	count[0] = 0;
+	for (uint8_t l = 1; l <= HUFFMAN_CODE_LENGTH_MAX; l++)
+	{
+		value = (value + count[l - 1]) << 1;
+		next[l] = value;
+	}
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		if (length[c] != 0)
+			code[c] = (huffman_code_t){.bits = next[length[c]]++, .length = length[c]};
+		else
+			code[c] = (huffman_code_t){.bits = 0, .length = 0};
+	}
+}
@@ -1,121 +1,350 @@
 #include "huffman/compress.h"
+#include "huffman/block.h"
 #include "huffman/build.h"
-#include "huffman/node.h"
+#include "huffman/code.h"
+#include "huffman/context.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/header.h"
+#include "huffman/histogram.h"
+#include "huffman/input.h"
+#include "huffman/parallel.h"
+#include "huffman/reader.h"
+#include "huffman/seekable.h"
+#include "huffman/split.h"
+#include "huffman/stats.h"
+#include "huffman/writer.h"
 #include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
 
-#define FAIL()                                                                                                         \
-	do                                                                                                             \
-	{                                                                                                              \
-		fprintf(stderr, "\nErreur : Lors de l'écriture (putc).\n\n");                                          \
-		exit(EXIT_FAILURE);                                                                                    \
-	} while (false)
+static bool compress_file(huffman_state_t *state, const huffman_options_t *options, huffman_input_t *input,
+                          FILE *wfd);
+static bool compress_default(huffman_state_t *state, huffman_input_t *input, FILE *wfd);
+static huffman_status_t compress_buffer(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                        uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+static bool compress_frame(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer);
+static bool compress_blocks(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer,
+                            huffman_seek_table_t *seek);
 
-void huffman_compress(huffman_state_t *state, FILE *rfd, FILE *wfd)
+/*
+ * Le fichier est lu deux fois par tranches de HUFFMAN_READER_BUFFER_SIZE octets : directement dans sa projection en
+ * mémoire si c'est un fichier régulier, avec fread() sinon. L'ancien format stocke la taille sur 32 bits et n'a pas de
+ * bloc stocké : au-delà de UINT32_MAX caractères, pour un seul caractère différent, ou si la taille calculée avec
+ * l'arbre dépasse huffman_compress_bound(), le second passage écrit le format par blocs avec les options par défaut,
+ * sans encoder l'ancien format : state->version n'est alors pas nul, et state->tree n'est pas l'arbre du fichier.
+ */
+bool huffman_compress(huffman_state_t *state, FILE *rfd, FILE *wfd)
 {
-	int32_t c;
-	int index;
-	unsigned char encode;
-	char *code[CHAR_COUNT];
-	char buff[CHAR_COUNT];
+	uint64_t count[CHAR_COUNT] = {0};
+	huffman_code_t code[CHAR_COUNT];
+	uint8_t chunk[HUFFMAN_READER_BUFFER_SIZE];
+	uint8_t buffer[HUFFMAN_WRITER_BUFFER_SIZE];
+	huffman_writer_t writer;
+	huffman_input_t input;
+	const uint8_t *data;
+	size_t size;
 
-	for (c = 0; c < CHAR_COUNT; c++)
+	huffman_state_init(state);
+	huffman_input_open(&input, rfd);
+	while ((size = huffman_input_read(&input, chunk, sizeof(chunk), &data)) > 0)
 	{
-		huffman_node_init_leaf(&state->tree.nodes[c], c, HUFFMAN_NODE_NONE);
+		huffman_histogram(count, data, size);
+		state->file_size += size;
 	}
-	for (c = fgetc(rfd); c != EOF; c = getc(rfd))
+	if (state->file_size > UINT32_MAX)
+		return compress_default(state, &input, wfd);
+	huffman_set_frequencies(state, count);
+	/* Un fichier vide donne un fichier compressé vide. */
+	if (!huffman_build(state) || !huffman_calculate_code(code, &state->tree))
 	{
-		if (state->tree.nodes[c].freq == UINT32_MAX)
-		{
-			fprintf(stderr, "\nLimite UINT_MAX atteinte.\n\n");
-			exit(EXIT_FAILURE);
-		}
-		state->tree.nodes[c].freq++;
-		if (state->file_size == SIZE_MAX)
-		{
-			fprintf(stderr, "\nLimite UINT_MAX atteinte.\n\n");
-			exit(EXIT_FAILURE);
-		}
-		state->file_size++;
+		huffman_input_close(&input);
+		return state->num_leaves == 0;
 	}
-	for (c = 0; c < 256; c++)
+	uint64_t bits = 0;
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+		bits += count[state->leaves[i]] * code[state->leaves[i]].length;
+	/* Taille, nombre de feuilles, feuilles, forme de l'arbre complétée à l'octet, puis les caractères codés. */
+	uint64_t length = 6 + state->num_leaves + (2 * state->num_leaves - 1 + 7) / 8 + (bits + 7) / 8;
+	if (state->num_leaves == 1 || length > huffman_compress_bound(NULL, state->file_size))
+		return compress_default(state, &input, wfd);
+
+	/* Compression */
+	huffman_writer_init(&writer, buffer, sizeof(buffer), wfd);
+	huffman_writer_put(&writer, state->file_size & 0xffffffff, 32);
+	if (state->num_leaves == CHAR_COUNT)
 	{
-		if (state->tree.nodes[c].freq != 0)
-			state->leaves[state->num_leaves++] = c;
+		huffman_writer_put(&writer, 1, 8);
+		huffman_writer_put(&writer, 255, 8);
 	}
-	if (!huffman_build(state))
-		return;
-	if (state->num_leaves == 1)
+	else
 	{
-		code[state->leaves[0]] = (char *)malloc(sizeof(char) * 2);
-		strcpy(code[state->leaves[0]], "0");
+		huffman_writer_put(&writer, 0, 8);
+		huffman_writer_put(&writer, state->num_leaves & 0xff, 8);
 	}
-	else
+	huffman_write_header(&writer, &state->tree);
+	huffman_write_tree(&writer, &state->tree);
+
+	huffman_input_rewind(&input);
+	while ((size = huffman_input_read(&input, chunk, sizeof(chunk), &data)) > 0)
+	{
+		for (size_t i = 0; i < size; i++)
+			huffman_writer_put(&writer, code[data[i]].bits, code[data[i]].length);
+	}
+	huffman_input_close(&input);
+	if (!huffman_writer_finish(&writer))
 	{
-		huffman_calculate_code(code, buff, state->tree.root, 0);
+		huffman_error_set("%s", huffman_writer_error(&writer));
+		return false;
 	}
-	huffman_print(code);
+	return true;
+}
 
-	/* Compression */
-	rewind(rfd);
-	huffman_write(wfd, state->file_size);
-	if (state->num_leaves == CHAR_COUNT)
+/*
+ * Second passage de huffman_compress() au format par blocs, avec les options par défaut. Ferme input.
+ */
+static bool compress_default(huffman_state_t *state, huffman_input_t *input, FILE *wfd)
+{
+	huffman_options_t options;
+
+	huffman_options_init(&options);
+	huffman_input_rewind(input);
+	bool ok = compress_file(state, &options, input, wfd);
+	huffman_input_close(input);
+	return ok;
+}
+
+/*
+ * Taille maximale du résultat de huffman_compress_buffer() pour size caractères (options peut être NULL). Un bloc que
+ * le codage ne raccourcit pas est stocké tel quel : chaque bloc coûte au plus son entête et sa somme de contrôle en
+ * plus de ses caractères, et son entrée dans l'index avec options->seekable. options->split ajoute au plus un bloc
+ * par fenêtre de découpage.
+ */
+size_t huffman_compress_bound(const huffman_options_t *options, size_t size)
+{
+	size_t block_size = options != NULL ? options->block_size : HUFFMAN_BLOCK_SIZE_DEFAULT;
+	size_t blocks = size / block_size + (size % block_size != 0);
+	if (options != NULL && options->split > 0)
+		blocks += size / HUFFMAN_SPLIT_WINDOW(options->split);
+	size_t bound = HUFFMAN_FRAME_HEADER_SIZE + blocks * (HUFFMAN_BLOCK_HEADER_SIZE + HUFFMAN_BLOCK_CHECKSUM_SIZE);
+	bound += size;
+	/* Bloc de fin et résumé de la trame. */
+	bound += 1 + HUFFMAN_FRAME_TRAILER_SIZE(HUFFMAN_FORMAT_VERSION);
+	if (options != NULL && options->seekable)
+		bound += blocks * HUFFMAN_SEEK_ENTRY_SIZE + HUFFMAN_SEEK_FOOTER_SIZE;
+	return bound;
+}
+
+/*
+ * Compression en un seul passage : l'entrée est découpée en blocs d'au plus options->block_size caractères, chacun
+ * avec son propre arbre. Un fichier régulier est projeté en mémoire et les blocs sont compressés sans copie ; sinon
+ * l'entrée est lue avec fread() et jamais rembobinée, elle peut donc être un tube ou l'entrée standard.
+ */
+bool huffman_compress_stream(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, FILE *wfd)
+{
+	huffman_input_t input;
+
+	huffman_input_open(&input, rfd);
+	bool ok = compress_file(state, options, &input, wfd);
+	huffman_input_close(&input);
+	return ok;
+}
+
+/*
+ * Comme huffman_compress_stream(), avec les size octets de data en entrée.
+ */
+bool huffman_compress_memory(huffman_state_t *state, const huffman_options_t *options, const uint8_t *data,
+                             size_t size, FILE *wfd)
+{
+	huffman_input_t input;
+
+	huffman_input_memory(&input, data, size);
+	return compress_file(state, options, &input, wfd);
+}
+
+/*
+ * Compresse src dans dst au format par blocs, sans fichier ni appel à exit(). options peut être NULL (options par
+ * défaut) ; toute la mémoire de travail vient de options->allocator. Un dst de huffman_compress_bound() octets
+ * suffit toujours. *dst_size reçoit la taille du résultat.
+ */
+huffman_status_t huffman_compress_buffer(const huffman_options_t *options, const uint8_t *src, size_t src_size,
+                                         uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	*dst_size = 0;
+	if (options != NULL && !huffman_options_check(options))
+		return kHuffmanErrorArgument;
+	huffman_stats_t *previous = huffman_stats_begin(options != NULL ? options->stats : NULL);
+	huffman_status_t status = kHuffmanErrorMemory;
+	huffman_context_t *context = huffman_context_new(options);
+	if (context != NULL)
+		status = compress_buffer(context, src, src_size, dst, dst_capacity, dst_size);
+	huffman_context_free(context);
+	huffman_stats_end(previous);
+	return status;
+}
+
+/*
+ * Comme huffman_compress_buffer(), avec la mémoire de travail de context : aucune allocation si options.threads vaut
+ * 1. Un bloc peut réutiliser le codage du dernier bloc canonique d'une trame précédente du même contexte.
+ */
+huffman_status_t huffman_context_compress(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                          uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	huffman_stats_t *previous = huffman_stats_begin(context->options.stats);
+	huffman_status_t status = compress_buffer(context, src, src_size, dst, dst_capacity, dst_size);
+	huffman_stats_end(previous);
+	return status;
+}
+
+/*
+ * Compresse input en une trame écrite à la suite de ce que writer contient déjà, par exemple dans une archive : la
+ * trame n'est jamais entière en mémoire, writer est vidé au fil de l'écriture. context->encoder donne ensuite le nombre
+ * de caractères et le CRC-32C de la trame.
+ */
+bool huffman_context_compress_input(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer)
+{
+	if (!huffman_options_check(&context->options))
+		return false;
+	huffman_stats_t *previous = huffman_stats_begin(context->options.stats);
+	bool ok = compress_frame(context, input, writer);
+	huffman_stats_end(previous);
+	return ok;
+}
+
+static huffman_status_t compress_buffer(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                        uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	huffman_input_t input;
+
+	*dst_size = 0;
+	if (!huffman_options_check(&context->options))
+		return kHuffmanErrorArgument;
+	huffman_writer_init(&context->writer, dst, dst_capacity, NULL);
+	huffman_input_memory(&input, src, src_size);
+	if (!compress_frame(context, &input, &context->writer))
+		return context->writer.failed ? kHuffmanErrorSize : kHuffmanErrorMemory;
+	*dst_size = context->writer.size;
+	return kHuffmanOk;
+}
+
+/*
+ * Chaque fichier est une trame indépendante, compressée avec un contexte neuf.
+ */
+static bool compress_file(huffman_state_t *state, const huffman_options_t *options, huffman_input_t *input,
+                          FILE *wfd)
+{
+	if (!huffman_options_check(options))
+		return false;
+	huffman_stats_t *previous = huffman_stats_begin(options->stats);
+	huffman_context_t *context = huffman_context_new(options);
+	if (context == NULL)
 	{
-		if (fputc(1, wfd) == EOF || fputc(255, wfd) == EOF)
-		{
-			FAIL();
-		}
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_stats_end(previous);
+		return false;
 	}
+	huffman_writer_init(&context->writer, context->output, sizeof(context->output), wfd);
+	bool ok = compress_frame(context, input, &context->writer);
+	state->file_size = context->encoder.total;
+	state->version = HUFFMAN_FORMAT_VERSION;
+	huffman_context_free(context);
+	huffman_stats_end(previous);
+	return ok;
+}
+
+/*
+ * Avec options->seekable, l'index des blocs est construit au fil de l'écriture puis écrit après le résumé de la trame.
+ */
+static bool compress_frame(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer)
+{
+	const huffman_options_t *options = &context->options;
+	huffman_frame_t *frame = &context->encoder;
+	huffman_seek_table_t table;
+	huffman_seek_table_t *seek = options->seekable ? &table : NULL;
+	uint64_t start = huffman_writer_tell(writer);
+	bool ok = true;
+
+	frame->total = 0;
+	frame->blocks = 0;
+	frame->checksum = 0;
+	frame->coded = 0;
+	huffman_seek_table_init(&table);
+
+	for (const char *magic = HUFFMAN_MAGIC; *magic != '\0'; magic++)
+		huffman_writer_put(writer, (uint8_t)*magic, 8);
+	huffman_writer_put(writer, HUFFMAN_FORMAT_VERSION, 8);
+	huffman_writer_put(writer, options->block_size, 32);
+	if (options->threads > 1)
+		ok = huffman_compress_parallel(options, input, writer, frame, seek);
 	else
+		ok = compress_blocks(context, input, writer, seek);
+	huffman_writer_put(writer, kHuffmanBlockEnd, 8);
+	huffman_writer_put(writer, frame->total, 64);
+	huffman_writer_put(writer, frame->blocks, 64);
+	huffman_writer_put(writer, frame->checksum, 32);
+	if (seek != NULL)
+		huffman_seek_table_write(seek, writer);
+	huffman_seek_table_free(&table, options->allocator);
+	context->state.file_size = frame->total;
+
+	if (!ok && !writer->failed)
+		return false;
+	if (huffman_input_error(input))
 	{
-		if (fputc(0, wfd) == EOF || putc(state->num_leaves & 0xff, wfd) == EOF)
-		{
-			FAIL();
-		}
+		huffman_error_set("Lecture du fichier (fread).");
+		return false;
 	}
-	huffman_write_header(wfd, state->tree.root);
-
-	uint8_t shift = 7;
-	uint8_t tmp = 0;
-	huffman_write_tree(wfd, state->tree.root, &tmp, &shift);
-	if (tmp != 0)
+	if (!huffman_writer_finish(writer))
 	{
-		if (fputc(tmp, wfd) == EOF)
-		{
-			FAIL();
-		}
+		huffman_error_set("%s", huffman_writer_error(writer));
+		return false;
 	}
-	shift = 0;
-	encode = 0;
-	for (c = fgetc(rfd); c != EOF; c = getc(rfd))
+	if (options->stats != NULL)
 	{
-		index = 0;
-		while (code[c][index] != '\0')
-		{
-			if (shift < 8)
-			{
-				encode = (encode << 1) + (code[c][index] == '0' ? 0 : 1);
-				shift++, index++;
-			}
-			else
-			{
-				if (fputc(encode, wfd) == EOF)
-				{
-					FAIL();
-				}
-				shift = 0, encode = 0;
-			}
-		}
+		options->stats->bytes_in = frame->total;
+		options->stats->bytes_out = (huffman_writer_tell(writer) - start) / 8;
+		options->stats->blocks = frame->blocks;
+		options->stats->bits = frame->coded;
+	}
+	return true;
+}
+
+/*
+ * Le tampon de lecture n'est alloué que si l'entrée est lue avec stdio, le modèle d'ordre 1 qu'avec options->contexts.
+ * Avec options->split, chaque tranche lue est découpée en blocs là où la distribution des caractères change.
+ * Avec un index (seek non NULL), les blocs ne réutilisent pas le codage d'un bloc précédent : chacun se décode seul.
+ */
+static bool compress_blocks(huffman_context_t *context, huffman_input_t *input, huffman_writer_t *writer,
+                            huffman_seek_table_t *seek)
+{
+	const huffman_options_t *options = &context->options;
+	huffman_block_t plan;
+	const uint8_t *block;
+	uint8_t *buffer = NULL;
+	size_t size;
+	bool ok = true;
+
+	if ((input->rfd != NULL && (buffer = huffman_alloc(options->allocator, options->block_size)) == NULL) ||
+	    (options->contexts > 0 && !huffman_model_reserve(&context->model, options->allocator, options->contexts)))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_free(options->allocator, buffer);
+		return false;
 	}
-	if (shift > 0)
+	plan.model = options->contexts > 0 ? context->model : NULL;
+	while (ok && !writer->failed && (size = huffman_input_read(input, buffer, options->block_size, &block)) > 0)
 	{
-		encode <<= (8 - shift);
-		if (fputc(encode, wfd) == EOF)
+		for (size_t length; ok && size > 0; block += length, size -= length)
 		{
-			FAIL();
+			const huffman_frame_t *frame = seek == NULL ? &context->encoder : NULL;
+			length = huffman_split(block, size, options->split);
+			if (!(ok = huffman_block_prepare(&context->state, &plan, block, length, options, frame)))
+				break;
+			huffman_block_write(&context->state, &plan, writer, block);
+			huffman_block_commit(&context->encoder, &plan);
+			ok = seek == NULL || huffman_seek_table_add(seek, options->allocator, plan.size, plan.length);
+			if (!ok)
+				huffman_error_set("Allocation mémoire dynamique.");
 		}
 	}
-	for (c = 0; c < state->num_leaves; c++)
-		free(code[state->leaves[c]]);
+	huffman_free(options->allocator, buffer);
+	return ok && !writer->failed;
 }
@@ -0,0 +1,63 @@
+#include "huffman/context.h"
+#include "huffman/error.h"
+
+/*
+ * options peut être NULL (options par défaut). Le contexte est alloué par options->allocator.
+ */
+huffman_context_t *huffman_context_new(const huffman_options_t *options)
+{
+	huffman_options_t defaults;
+
+	if (options == NULL)
+	{
+		huffman_options_init(&defaults);
+		options = &defaults;
+	}
+	huffman_context_t *context = huffman_alloc(options->allocator, sizeof(huffman_context_t));
+	if (context == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	context->options = *options;
+	context->scratch = NULL;
+	context->scratch_size = 0;
+	context->model = NULL;
+	huffman_state_init(&context->state);
+	huffman_context_reset(context);
+	return context;
+}
+
+void huffman_context_reset(huffman_context_t *context)
+{
+	huffman_frame_init(&context->encoder);
+	huffman_frame_init(&context->decoder);
+}
+
+void huffman_context_free(huffman_context_t *context)
+{
+	if (context == NULL)
+		return;
+	huffman_free(context->options.allocator, context->scratch);
+	huffman_model_free(context->model, context->options.allocator);
+	huffman_free(context->options.allocator, context);
+}
+
+/*
+ * Tampon d'au moins size octets, gardé jusqu'à huffman_context_free() : seuls les blocs entrelacés lus dans un
+ * fichier en ont besoin, il n'est donc pas alloué par huffman_context_new().
+ */
+uint8_t *huffman_context_scratch(huffman_context_t *context, size_t size)
+{
+	if (size <= context->scratch_size)
+		return context->scratch;
+	huffman_free(context->options.allocator, context->scratch);
+	context->scratch_size = 0;
+	if ((context->scratch = huffman_alloc(context->options.allocator, size)) == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	context->scratch_size = size;
+	return context->scratch;
+}
@@ -0,0 +1,199 @@
+#include "huffman/decode.h"
+
+static void fill(huffman_decode_table_t *table, const huffman_tree_t *tree, uint16_t base, uint8_t bits,
+                 uint16_t node, uint8_t depth, uint16_t code);
+static uint8_t height(const huffman_tree_t *tree, uint16_t node, uint8_t limit);
+static inline uint8_t decode_symbol(huffman_reader_t *reader, const huffman_decode_entry_t *entries,
+                                    const huffman_node_t *nodes);
+static bool decode_one(huffman_streams_t *streams, const huffman_decode_table_t *table, const huffman_tree_t *tree,
+                       uint8_t *data);
+
+void huffman_decode_table_build(huffman_decode_table_t *table, const huffman_tree_t *tree)
+{
+	table->size = 1 << HUFFMAN_DECODE_ROOT_BITS;
+	table->bits = HUFFMAN_DECODE_ROOT_BITS;
+	if (tree->nodes[tree->root].type == kHuffmanNodeLeaf)
+	{
+		/* Une seule feuille : l'encodeur écrit le codage "0" sur un bit pour chaque caractère. */
+		huffman_decode_entry_t entry = {
+		    .value = tree->nodes[tree->root].u.leaf.c, .length = 1, .type = kHuffmanEntrySymbol};
+		for (uint16_t i = 0; i < table->size; i++)
+			table->entries[i] = entry;
+		return;
+	}
+	fill(table, tree, 0, HUFFMAN_DECODE_ROOT_BITS, tree->root, 0, 0);
+}
+
+/*
+ * Décode count caractères dans data. Renvoie faux si l'entrée se termine avant.
+ */
+bool huffman_decode(huffman_reader_t *reader, const huffman_decode_table_t *table, const huffman_tree_t *tree,
+                    uint8_t *data, size_t count)
+{
+	const huffman_decode_entry_t *entries = table->entries;
+	const huffman_node_t *nodes = tree->nodes;
+	uint8_t *end = data + count;
+
+	while (data < end)
+	{
+		huffman_reader_refill(reader);
+		while (reader->count >= HUFFMAN_DECODE_ROOT_BITS + HUFFMAN_DECODE_SUB_BITS && data < end)
+			*data++ = decode_symbol(reader, entries, nodes);
+		if (huffman_reader_truncated(reader))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Comme huffman_decode(), les caractères venant à tour de rôle de chaque flux à partir de streams->next. Les flux
+ * sont indépendants : un tour décode un caractère de chacun, et le processeur mène leurs chaînes de dépendances en
+ * parallèle au lieu d'attendre la longueur de chaque codage avant de lire le suivant.
+ */
+bool huffman_decode_streams(huffman_streams_t *streams, const huffman_decode_table_t *table,
+                            const huffman_tree_t *tree, uint8_t *data, size_t count)
+{
+	const huffman_decode_entry_t *entries = table->entries;
+	const huffman_node_t *nodes = tree->nodes;
+	huffman_reader_t *readers = streams->readers;
+	uint8_t n = streams->count;
+	uint8_t *end = data + count;
+	/*
+	 * Un remplissage garantit 56 bits : assez pour 56 / table->bits codages lus dans la table principale et une
+	 * sous-table, soit trois codages canoniques (15 bits au plus) mais deux seulement pour un arbre dont les codages
+	 * vont jusqu'à la profondeur des sous-tables. Le parcours de l'arbre au-delà remplit lui-même le lecteur.
+	 */
+	uint8_t rounds = 56 / table->bits;
+
+	while (data < end && streams->next != 0)
+		if (!decode_one(streams, table, tree, data++))
+			return false;
+	while ((size_t)(end - data) >= rounds * (size_t)n)
+	{
+		for (uint8_t i = 0; i < n; i++)
+			huffman_reader_refill(&readers[i]);
+		for (uint8_t round = 0; round < rounds; round++)
+			for (uint8_t i = 0; i < n; i++)
+				*data++ = decode_symbol(&readers[i], entries, nodes);
+	}
+	while (data < end)
+		if (!decode_one(streams, table, tree, data++))
+			return false;
+	for (uint8_t i = 0; i < n; i++)
+		if (huffman_reader_truncated(&readers[i]))
+			return false;
+	return true;
+}
+
+/*
+ * Vrai si chaque flux a été lu exactement jusqu'à son dernier octet.
+ */
+bool huffman_streams_end(huffman_streams_t *streams)
+{
+	for (uint8_t i = 0; i < streams->count; i++)
+	{
+		huffman_reader_t *reader = &streams->readers[i];
+		huffman_reader_align(reader);
+		if (huffman_reader_truncated(reader) || huffman_reader_tell(reader) != (uint64_t)reader->end * 8)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Lit un caractère dans la table (et la sous-table), puis dans l'arbre au-delà. reader doit contenir au moins
+ * HUFFMAN_DECODE_ROOT_BITS + HUFFMAN_DECODE_SUB_BITS bits.
+ */
+static inline uint8_t decode_symbol(huffman_reader_t *reader, const huffman_decode_entry_t *entries,
+                                    const huffman_node_t *nodes)
+{
+	huffman_decode_entry_t entry = entries[reader->bits >> (64 - HUFFMAN_DECODE_ROOT_BITS)];
+	if (entry.type != kHuffmanEntrySymbol)
+	{
+		huffman_reader_consume(reader, HUFFMAN_DECODE_ROOT_BITS);
+		entry = entries[entry.value + (reader->bits >> (64 - entry.length))];
+		if (entry.type == kHuffmanEntryNode)
+		{
+			uint16_t node = entry.value;
+			huffman_reader_consume(reader, entry.length);
+			while (nodes[node].type == kHuffmanNodeNode)
+			{
+				huffman_reader_refill(reader);
+				node = reader->bits >> 63 ? nodes[node].u.node.right_child
+				                          : nodes[node].u.node.left_child;
+				huffman_reader_consume(reader, 1);
+			}
+			entry.value = nodes[node].u.leaf.c;
+			entry.length = 0;
+		}
+	}
+	huffman_reader_consume(reader, entry.length);
+	return entry.value;
+}
+
+/*
+ * Décode un caractère du flux streams->next, puis passe au flux suivant.
+ */
+static bool decode_one(huffman_streams_t *streams, const huffman_decode_table_t *table, const huffman_tree_t *tree,
+                       uint8_t *data)
+{
+	huffman_reader_t *reader = &streams->readers[streams->next];
+	streams->next = streams->next + 1 == streams->count ? 0 : streams->next + 1;
+	return huffman_decode(reader, table, tree, data, 1);
+}
+
+/*
+ * Remplit les 2^bits entrées à partir de base pour le sous-arbre de node. Une feuille à la profondeur depth occupe
+ * 2^(bits - depth) entrées consécutives. Un noeud interne atteint après bits bits devient une sous-table s'il est
+ * dans la table principale, sinon un point de reprise pour un parcours bit à bit.
+ */
+static void fill(huffman_decode_table_t *table, const huffman_tree_t *tree, uint16_t base, uint8_t bits,
+                 uint16_t node, uint8_t depth, uint16_t code)
+{
+	const huffman_node_t *current = &tree->nodes[node];
+	huffman_decode_entry_t entry;
+
+	if (current->type == kHuffmanNodeLeaf)
+	{
+		entry.value = current->u.leaf.c;
+		entry.length = depth;
+		entry.type = kHuffmanEntrySymbol;
+		uint16_t first = base + (code << (bits - depth));
+		uint16_t last = first + (1 << (bits - depth));
+		for (uint16_t i = first; i < last; i++)
+			table->entries[i] = entry;
+	}
+	else if (depth < bits)
+	{
+		fill(table, tree, base, bits, current->u.node.left_child, depth + 1, code << 1);
+		fill(table, tree, base, bits, current->u.node.right_child, depth + 1, code << 1 | 1);
+	}
+	else if (base == 0)
+	{
+		entry.value = table->size;
+		entry.length = height(tree, node, HUFFMAN_DECODE_SUB_BITS);
+		entry.type = kHuffmanEntryTable;
+		table->entries[code] = entry;
+		table->size += 1 << entry.length;
+		if (HUFFMAN_DECODE_ROOT_BITS + entry.length > table->bits)
+			table->bits = HUFFMAN_DECODE_ROOT_BITS + entry.length;
+		fill(table, tree, entry.value, entry.length, node, 0, 0);
+	}
+	else
+	{
+		entry.value = node;
+		entry.length = bits;
+		entry.type = kHuffmanEntryNode;
+		table->entries[base + code] = entry;
+	}
+}
+
+static uint8_t height(const huffman_tree_t *tree, uint16_t node, uint8_t limit)
+{
+	const huffman_node_t *current = &tree->nodes[node];
+	if (limit == 0 || current->type == kHuffmanNodeLeaf)
+		return 0;
+	uint8_t left = height(tree, current->u.node.left_child, limit - 1);
+	uint8_t right = height(tree, current->u.node.right_child, limit - 1);
+	return 1 + (left > right ? left : right);
+}
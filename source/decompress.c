@@ -0,0 +1,468 @@
+#include "huffman/decompress.h"
+#include "huffman/block.h"
+#include "huffman/checksum.h"
+#include "huffman/context.h"
+#include "huffman/decode.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/header.h"
+#include "huffman/input.h"
+#include "huffman/limits.h"
+#include "huffman/parallel.h"
+#include "huffman/reader.h"
+#include "huffman/stats.h"
+#include <stdint.h>
+#include <string.h>
+
+static bool decompress_file(huffman_state_t *state, const huffman_options_t *options, FILE *rfd,
+                            huffman_writer_t *writer);
+static huffman_status_t decompress_buffer(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                          uint8_t *dst, size_t dst_capacity, size_t *dst_size);
+static bool decompress(huffman_context_t *context);
+static bool is_frame(const huffman_reader_t *reader);
+static bool decompress_frame(huffman_context_t *context);
+static bool decompress_tree(huffman_context_t *context, const huffman_block_t *block, uint64_t count);
+static bool check_trailer(huffman_reader_t *reader, uint8_t version, const huffman_frame_t *frame);
+static bool discard(void *opaque, const uint8_t *data, size_t size);
+
+bool huffman_decompress(huffman_state_t *state, FILE *rfd, FILE *wfd)
+{
+	huffman_options_t options;
+	huffman_options_init(&options);
+	return huffman_decompress_stream(state, &options, rfd, wfd);
+}
+
+/*
+ * Décompresse l'ancien format (un seul arbre) ou le format par blocs, reconnu à son entête. Un fichier régulier est
+ * lu directement dans sa projection en mémoire.
+ */
+bool huffman_decompress_stream(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, FILE *wfd)
+{
+	huffman_writer_t writer;
+
+	huffman_writer_init(&writer, NULL, 0, wfd);
+	return decompress_file(state, options, rfd, &writer);
+}
+
+/*
+ * Comme huffman_decompress_stream(), les caractères décodés étant passés à sink par tranches de
+ * HUFFMAN_OUTPUT_BUFFER_SIZE octets (par exemple pour les écrire avec write() ou dans une projection en mémoire).
+ */
+bool huffman_decompress_sink(huffman_state_t *state, const huffman_options_t *options, FILE *rfd, huffman_sink_t sink,
+                             void *opaque)
+{
+	huffman_writer_t writer;
+
+	huffman_writer_init_sink(&writer, NULL, 0, sink, opaque);
+	return decompress_file(state, options, rfd, &writer);
+}
+
+/*
+ * Vérifie un fichier compressé sans écrire ses caractères : ils sont décodés dans le tampon de sortie puis oubliés, et
+ * les sommes de contrôle de chaque bloc et de la trame sont vérifiées comme lors de la décompression.
+ */
+bool huffman_decompress_verify(huffman_state_t *state, const huffman_options_t *options, FILE *rfd)
+{
+	huffman_writer_t writer;
+
+	huffman_writer_init_sink(&writer, NULL, 0, discard, NULL);
+	return decompress_file(state, options, rfd, &writer);
+}
+
+/*
+ * Décompresse src dans dst, sans fichier. options peut être NULL (options par défaut) ; toute la mémoire de travail
+ * vient de options->allocator. *dst_size reçoit le nombre de caractères décompressés.
+ */
+huffman_status_t huffman_decompress_buffer(const huffman_options_t *options, const uint8_t *src, size_t src_size,
+                                           uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	*dst_size = 0;
+	huffman_stats_t *previous = huffman_stats_begin(options != NULL ? options->stats : NULL);
+	huffman_status_t status = kHuffmanErrorMemory;
+	huffman_context_t *context = huffman_context_new(options);
+	if (context != NULL)
+		status = decompress_buffer(context, src, src_size, dst, dst_capacity, dst_size);
+	huffman_context_free(context);
+	huffman_stats_end(previous);
+	return status;
+}
+
+/*
+ * Comme huffman_decompress_buffer(), avec la mémoire de travail de context. Les trames doivent arriver dans l'ordre
+ * où le contexte de compression les a produites depuis le dernier huffman_context_reset().
+ */
+huffman_status_t huffman_context_decompress(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                            uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	huffman_stats_t *previous = huffman_stats_begin(context->options.stats);
+	huffman_status_t status = decompress_buffer(context, src, src_size, dst, dst_capacity, dst_size);
+	huffman_stats_end(previous);
+	return status;
+}
+
+/*
+ * Décompresse la trame rangée dans les length octets de rfd à partir de offset, lus avec pread() : plusieurs contextes
+ * lisent le même fichier en même temps sans déplacer sa position, et la trame n'est jamais entière en mémoire. Les
+ * caractères décodés sont passés à sink par tranches de HUFFMAN_WRITER_BUFFER_SIZE octets. Ensuite,
+ * context->state.file_size donne leur nombre et context->decoder leur CRC-32C.
+ */
+bool huffman_context_decompress_range(huffman_context_t *context, FILE *rfd, uint64_t offset, uint64_t length,
+                                      huffman_sink_t sink, void *opaque)
+{
+	huffman_stats_t *previous = huffman_stats_begin(context->options.stats);
+	huffman_reader_init_range(&context->reader, rfd, offset, length, context->input, sizeof(context->input));
+	huffman_writer_init_sink(&context->writer, context->output, sizeof(context->output), sink, opaque);
+	bool ok = decompress(context);
+	huffman_stats_end(previous);
+	return ok;
+}
+
+/*
+ * Décompresse un seul bloc (src commence par son entête) d'une trame dont la taille maximale des blocs est
+ * block_size, sans lire le reste de la trame. Un bloc kHuffmanBlockRepeat reprend le codage du dernier bloc décompressé
+ * par le contexte depuis huffman_context_reset(), et est refusé juste après. Le CRC-32C des caractères du bloc est
+ * vérifié, puis ajouté à celui de la trame en cours de décompression du contexte.
+ */
+huffman_status_t huffman_context_decompress_block(huffman_context_t *context, uint32_t block_size, const uint8_t *src,
+                                                  size_t src_size, uint8_t *dst, size_t dst_capacity,
+                                                  size_t *dst_size)
+{
+	huffman_reader_t *reader = &context->reader;
+	huffman_block_t block;
+	huffman_status_t status = kHuffmanErrorData;
+
+	*dst_size = 0;
+	huffman_stats_t *previous = huffman_stats_begin(context->options.stats);
+	huffman_reader_init_memory(reader, src, src_size);
+	huffman_writer_init(&context->writer, dst, dst_capacity, NULL);
+	bool header = huffman_block_read_header(reader, &block, block_size);
+	if (header && block.size == 0)
+		huffman_error_set("Bloc de fin de trame au lieu d'un bloc de données.");
+	if (header && block.size > 0)
+	{
+		uint64_t start = huffman_reader_tell(reader);
+		if (block.size > dst_capacity)
+		{
+			huffman_error_set("Tampon de sortie trop petit.");
+			status = kHuffmanErrorSize;
+		}
+		else if (decompress_tree(context, &block, block.size))
+		{
+			huffman_reader_align(reader);
+			if (huffman_reader_tell(reader) - start == (uint64_t)block.length * 8)
+			{
+				*dst_size = block.size;
+				status = kHuffmanOk;
+			}
+			else
+			{
+				huffman_error_set("Taille de bloc compressé incohérente.");
+			}
+		}
+	}
+	huffman_stats_end(previous);
+	return status;
+}
+
+/*
+ * writer donne la destination ; son tampon de HUFFMAN_OUTPUT_BUFFER_SIZE octets est alloué ici, les caractères y sont
+ * décodés directement.
+ */
+static bool decompress_file(huffman_state_t *state, const huffman_options_t *options, FILE *rfd,
+                            huffman_writer_t *writer)
+{
+	huffman_input_t input;
+
+	huffman_stats_t *previous = huffman_stats_begin(options->stats);
+	huffman_context_t *context = huffman_context_new(options);
+	uint8_t *output = huffman_alloc(options->allocator, HUFFMAN_OUTPUT_BUFFER_SIZE);
+	if (context == NULL || output == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_free(options->allocator, output);
+		huffman_context_free(context);
+		huffman_stats_end(previous);
+		return false;
+	}
+	if (huffman_input_open(&input, rfd))
+		huffman_reader_init_memory(&context->reader, input.data, input.size);
+	else
+		huffman_reader_init_file(&context->reader, rfd, context->input, sizeof(context->input));
+	context->writer = *writer;
+	context->writer.data = output;
+	context->writer.capacity = HUFFMAN_OUTPUT_BUFFER_SIZE;
+
+	bool ok = decompress(context);
+	state->file_size = context->state.file_size;
+	state->version = context->state.version;
+	huffman_input_close(&input);
+	huffman_free(options->allocator, output);
+	huffman_context_free(context);
+	huffman_stats_end(previous);
+	return ok;
+}
+
+static huffman_status_t decompress_buffer(huffman_context_t *context, const uint8_t *src, size_t src_size,
+                                          uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	*dst_size = 0;
+	huffman_reader_init_memory(&context->reader, src, src_size);
+	huffman_writer_init(&context->writer, dst, dst_capacity, NULL);
+	if (!decompress(context))
+		return context->writer.failed ? kHuffmanErrorSize : kHuffmanErrorData;
+	*dst_size = context->writer.size;
+	return kHuffmanOk;
+}
+
+static bool decompress(huffman_context_t *context)
+{
+	huffman_state_t *state = &context->state;
+	bool ok = true;
+
+	huffman_reader_refill(&context->reader);
+	state->version = 0;
+	if (context->reader.padding >= context->reader.count)
+	{
+		state->file_size = 0;
+	}
+	else if (is_frame(&context->reader))
+	{
+		ok = decompress_frame(context);
+	}
+	else
+	{
+		state->file_size = huffman_reader_get(&context->reader, 32);
+		context->decoder.has_code = false;
+		ok = decompress_tree(context, NULL, state->file_size);
+		HUFFMAN_STATS_ADD(blocks, 1);
+		HUFFMAN_STATS_ADD(bytes_in, huffman_reader_tell(&context->reader) / 8);
+		HUFFMAN_STATS_ADD(bytes_out, state->file_size);
+	}
+	if (ok && !huffman_writer_finish(&context->writer))
+	{
+		huffman_error_set("%s", huffman_writer_error(&context->writer));
+		return false;
+	}
+	return ok;
+}
+
+static bool is_frame(const huffman_reader_t *reader)
+{
+	uint64_t magic = 0;
+	for (const char *c = HUFFMAN_MAGIC; *c != '\0'; c++)
+		magic = magic << 8 | (uint8_t)*c;
+	return reader->bits >> 32 == magic && (reader->bits >> 24 & 0xff) >= HUFFMAN_FORMAT_VERSION_MIN;
+}
+
+static bool decompress_frame(huffman_context_t *context)
+{
+	huffman_reader_t *reader = &context->reader;
+	huffman_frame_t *frame = &context->decoder;
+	huffman_block_t block;
+
+	frame->total = 0;
+	frame->blocks = 0;
+	frame->checksum = 0;
+	huffman_reader_consume(reader, 8 * HUFFMAN_MAGIC_SIZE);
+	uint8_t version = huffman_reader_get(reader, 8);
+	uint32_t block_size = huffman_reader_get(reader, 32);
+	if (version > HUFFMAN_FORMAT_VERSION)
+	{
+		huffman_error_set("Version du format non supportée (%d).", version);
+		return false;
+	}
+	if (block_size > HUFFMAN_BLOCK_SIZE_MAX)
+	{
+		huffman_error_set("Taille de bloc invalide (%u).", block_size);
+		return false;
+	}
+	if (context->options.threads > 1)
+	{
+		if (!huffman_decompress_parallel(&context->options, reader, block_size, &context->writer, frame))
+		{
+			if (context->writer.failed)
+				huffman_error_set("%s", huffman_writer_error(&context->writer));
+			return false;
+		}
+		context->state.file_size = frame->total;
+		context->state.version = version;
+		return check_trailer(reader, version, frame);
+	}
+	for (;;)
+	{
+		if (!huffman_block_read_header(reader, &block, block_size))
+			return false;
+		if (block.size == 0)
+			break;
+		uint64_t start = huffman_reader_tell(reader);
+		if (!decompress_tree(context, &block, block.size))
+			return false;
+		huffman_reader_align(reader);
+		if (huffman_reader_tell(reader) - start != (uint64_t)block.length * 8)
+		{
+			huffman_error_set("Taille de bloc compressé incohérente.");
+			return false;
+		}
+		frame->total += block.size;
+		frame->blocks++;
+	}
+	context->state.file_size = frame->total;
+	context->state.version = version;
+	return check_trailer(reader, version, frame);
+}
+
+/*
+ * Depuis la version 3, le bloc de fin est suivi du nombre total de caractères et du nombre de blocs, depuis la
+ * version 10 du CRC-32C de tous les caractères.
+ */
+static bool check_trailer(huffman_reader_t *reader, uint8_t version, const huffman_frame_t *frame)
+{
+	HUFFMAN_STATS_ADD(bytes_in, HUFFMAN_FRAME_HEADER_SIZE + 1);
+	if (version < 3)
+		return true;
+	HUFFMAN_STATS_ADD(bytes_in, HUFFMAN_FRAME_TRAILER_SIZE(version));
+	uint64_t expected_total = (uint64_t)huffman_reader_get(reader, 32) << 32;
+	expected_total |= huffman_reader_get(reader, 32);
+	uint64_t expected_blocks = (uint64_t)huffman_reader_get(reader, 32) << 32;
+	expected_blocks |= huffman_reader_get(reader, 32);
+	uint32_t expected_checksum = version >= HUFFMAN_FORMAT_VERSION_CHECKSUM ? huffman_reader_get(reader, 32) : frame->checksum;
+	if (huffman_reader_truncated(reader))
+	{
+		huffman_error_set("Fichier tronqué.");
+		return false;
+	}
+	if (expected_total != frame->total || expected_blocks != frame->blocks)
+	{
+		huffman_error_set("Taille totale incohérente.");
+		return false;
+	}
+	if (expected_checksum != frame->checksum)
+	{
+		huffman_error_set("Somme de contrôle de la trame invalide.");
+		return false;
+	}
+	return true;
+}
+
+static bool discard(void *opaque, const uint8_t *data, size_t size)
+{
+	(void)opaque;
+	(void)data;
+	(void)size;
+	return true;
+}
+
+/*
+ * Lit l'entête d'un arbre (ou des longueurs pour un bloc canonique ; block est NULL pour l'ancien format) puis décode
+ * count caractères directement dans le tampon de l'écrivain, vidé lorsqu'il est plein. Un bloc kHuffmanBlockDictionary
+ * est décodé avec la table construite au chargement du dictionnaire, un bloc entrelacé avec un lecteur par flux et un
+ * bloc kHuffmanBlockContext avec les tables de son modèle, chaque caractère selon le précédent. Les caractères d'un
+ * bloc kHuffmanBlockStored sont copiés, le caractère d'un bloc kHuffmanBlockRun répété. Le CRC-32C des caractères
+ * d'un bloc est calculé sur chaque tranche d'au plus HUFFMAN_CHECKSUM_CHUNK octets dès qu'elle est décodée, puis
+ * comparé à la somme de contrôle du bloc.
+ */
+static bool decompress_tree(huffman_context_t *context, const huffman_block_t *block, uint64_t count)
+{
+	huffman_state_t *state = &context->state;
+	huffman_writer_t *writer = &context->writer;
+	const huffman_tree_t *tree = &state->tree;
+	const huffman_decode_table_t *table = &context->table;
+	bool interleaved = block != NULL && block->streams != 1;
+	bool modelled = block != NULL && block->type == kHuffmanBlockContext;
+	bool stored = block != NULL && block->type == kHuffmanBlockStored;
+	bool run = block != NULL && block->type == kHuffmanBlockRun;
+	huffman_streams_t streams;
+	uint32_t checksum = 0;
+	uint8_t last = 0;
+
+	HUFFMAN_STATS_START(start);
+	if (block != NULL && block->type == kHuffmanBlockDictionary)
+	{
+		const huffman_dictionary_t *dictionary =
+			huffman_block_read_dictionary(&context->reader, context->options.dictionary, &context->decoder);
+		if (dictionary == NULL)
+			return false;
+		tree = &dictionary->state.tree;
+		table = &dictionary->table;
+	}
+	else if (modelled)
+	{
+		if (!huffman_model_read(&context->model, context->options.allocator, &context->reader))
+			return false;
+	}
+	else if (run)
+	{
+		last = huffman_reader_get(&context->reader, 8);
+	}
+	else if (!stored)
+	{
+		if (block != NULL ? !huffman_block_read_code(&context->reader, block, state, &context->decoder)
+		                  : !huffman_read_header(&context->reader, state))
+			return false;
+		huffman_decode_table_build(&context->table, tree);
+	}
+	HUFFMAN_STATS_STOP(kHuffmanStageTable, start);
+	if (interleaved)
+	{
+		uint8_t *scratch = NULL;
+		if (context->reader.rfd != NULL && (scratch = huffman_context_scratch(context, block->length)) == NULL)
+			return false;
+		if (!huffman_block_read_streams(&context->reader, block, &streams, scratch))
+			return false;
+	}
+	while (count > 0)
+	{
+		if (writer->size == writer->capacity && !huffman_writer_flush(writer))
+		{
+			huffman_error_set("%s", huffman_writer_error(writer));
+			return false;
+		}
+		size_t n = writer->capacity - writer->size;
+		if (count < n)
+			n = count;
+		if (block != NULL && n > HUFFMAN_CHECKSUM_CHUNK)
+			n = HUFFMAN_CHECKSUM_CHUNK;
+		uint8_t *data = writer->data + writer->size;
+		bool ok;
+		HUFFMAN_STATS_START(decode);
+		if (modelled)
+		{
+			ok = huffman_model_decode(context->model, &context->reader, data, n, &last);
+		}
+		else if (stored)
+		{
+			ok = huffman_reader_bytes(&context->reader, data, n);
+		}
+		else if (run)
+		{
+			memset(data, last, n);
+			ok = !huffman_reader_truncated(&context->reader);
+		}
+		else if (interleaved)
+		{
+			ok = huffman_decode_streams(&streams, table, tree, data, n);
+		}
+		else
+		{
+			ok = huffman_decode(&context->reader, table, tree, data, n);
+		}
+		HUFFMAN_STATS_STOP(kHuffmanStageDecode, decode);
+		if (!ok)
+		{
+			huffman_error_set("Fichier tronqué.");
+			return false;
+		}
+		HUFFMAN_STATS_START(sum);
+		if (block != NULL)
+			checksum = huffman_crc32c(checksum, data, n);
+		HUFFMAN_STATS_STOP(kHuffmanStageChecksum, sum);
+		writer->size += n;
+		count -= n;
+	}
+	if (interleaved && !huffman_streams_end(&streams))
+	{
+		huffman_error_set("Taille de flux incohérente.");
+		return false;
+	}
+	return block == NULL || huffman_block_check(&context->reader, block, checksum, &context->decoder);
+}
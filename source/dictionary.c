@@ -0,0 +1,112 @@
+#include "huffman/dictionary.h"
+#include "huffman/build.h"
+#include "huffman/code.h"
+#include "huffman/error.h"
+#include "huffman/header.h"
+#include "huffman/reader.h"
+#include "huffman/writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool prepare(huffman_dictionary_t *dictionary);
+
+huffman_dictionary_t *huffman_dictionary_new(void)
+{
+	huffman_dictionary_t *dictionary = calloc(1, sizeof(huffman_dictionary_t));
+	if (dictionary == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	huffman_state_init(&dictionary->state);
+	return dictionary;
+}
+
+/*
+ * Construit le codage à partir des fréquences count des échantillons. Chaque caractère compte une fois de plus : les
+ * caractères absents des échantillons reçoivent un codage long, et tout message peut être codé avec le dictionnaire.
+ */
+bool huffman_dictionary_train(huffman_dictionary_t *dictionary, uint32_t id, const uint64_t count[CHAR_COUNT],
+                              uint8_t max_length)
+{
+	uint64_t smoothed[CHAR_COUNT];
+	uint64_t total = 0;
+	uint64_t bits = 0;
+
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		smoothed[c] = count[c] + 1;
+		total += count[c];
+	}
+	huffman_state_init(&dictionary->state);
+	huffman_set_frequencies(&dictionary->state, smoothed);
+	if (!huffman_build(&dictionary->state))
+		return false;
+	huffman_code_lengths(dictionary->lengths, &dictionary->state, max_length);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		bits += count[c] * dictionary->lengths[c];
+	dictionary->id = id;
+	dictionary->rate = total > 0 ? (uint32_t)((double)bits / total * HUFFMAN_DICTIONARY_RATE_ONE)
+	                             : 8 * HUFFMAN_DICTIONARY_RATE_ONE;
+	return prepare(dictionary);
+}
+
+bool huffman_dictionary_save(const huffman_dictionary_t *dictionary, FILE *wfd)
+{
+	uint8_t buffer[HUFFMAN_DICTIONARY_SIZE + 8];
+	huffman_writer_t writer;
+
+	huffman_writer_init(&writer, buffer, sizeof(buffer), wfd);
+	for (const char *magic = HUFFMAN_DICTIONARY_MAGIC; *magic != '\0'; magic++)
+		huffman_writer_put(&writer, (uint8_t)*magic, 8);
+	huffman_writer_put(&writer, HUFFMAN_DICTIONARY_VERSION, 8);
+	huffman_writer_put(&writer, dictionary->id, 32);
+	huffman_writer_put(&writer, dictionary->rate, 32);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		huffman_writer_put(&writer, dictionary->lengths[c], 4);
+	if (!huffman_writer_finish(&writer))
+	{
+		huffman_error_set("%s", huffman_writer_error(&writer));
+		return false;
+	}
+	return true;
+}
+
+bool huffman_dictionary_load(huffman_dictionary_t *dictionary, FILE *rfd)
+{
+	uint8_t buffer[HUFFMAN_DICTIONARY_SIZE];
+	huffman_reader_t reader;
+
+	if (fread(buffer, 1, sizeof(buffer), rfd) != sizeof(buffer) ||
+	    memcmp(buffer, HUFFMAN_DICTIONARY_MAGIC, strlen(HUFFMAN_DICTIONARY_MAGIC)) != 0)
+	{
+		huffman_error_set("Fichier de dictionnaire invalide.");
+		return false;
+	}
+	size_t magic = strlen(HUFFMAN_DICTIONARY_MAGIC);
+	huffman_reader_init_memory(&reader, buffer + magic, sizeof(buffer) - magic);
+	uint8_t version = huffman_reader_get(&reader, 8);
+	if (version != HUFFMAN_DICTIONARY_VERSION)
+	{
+		huffman_error_set("Version du dictionnaire non supportée (%d).", version);
+		return false;
+	}
+	dictionary->id = huffman_reader_get(&reader, 32);
+	dictionary->rate = huffman_reader_get(&reader, 32);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		dictionary->lengths[c] = huffman_reader_get(&reader, 4);
+	return prepare(dictionary);
+}
+
+/*
+ * Reconstruit l'arbre à partir des longueurs, ce qui vérifie qu'elles forment un codage complet, puis la table de
+ * décodage.
+ */
+static bool prepare(huffman_dictionary_t *dictionary)
+{
+	huffman_state_init(&dictionary->state);
+	if (!huffman_build_canonical(&dictionary->state, dictionary->lengths))
+		return false;
+	huffman_decode_table_build(&dictionary->table, &dictionary->state.tree);
+	return true;
+}
@@ -0,0 +1,26 @@
+#include "huffman/error.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static _Thread_local char message[HUFFMAN_ERROR_SIZE];
+
+void huffman_error_set(const char *format, ...)
+{
+	/*
+	 * Le format peut citer le message courant (huffman_error_set("... (%s)", huffman_error())) : le nouveau message est
+	 * formaté à part avant de le remplacer.
+	 */
+	char buffer[HUFFMAN_ERROR_SIZE];
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	memcpy(message, buffer, sizeof(message));
+}
+
+const char *huffman_error(void)
+{
+	return message;
+}
@@ -0,0 +1,287 @@
+#include "huffman/header.h"
+#include "huffman/error.h"
+#include "huffman/limits.h"
+#include "huffman/node.h"
+#include <stdbool.h>
+#include <string.h>
+
+static void write_preorder(huffman_writer_t *writer, const huffman_tree_t *tree, bool shape);
+static bool read_tree(huffman_reader_t *reader, huffman_state_t *state);
+static bool read_padding(huffman_reader_t *reader);
+static bool insert_code(huffman_tree_t *tree, uint16_t *next, uint8_t c, huffman_code_t code);
+
+/*
+ * Écrit les caractères des feuilles de gauche à droite, dans l'ordre où huffman_write_tree() rencontre les feuilles.
+ */
+void huffman_write_header(huffman_writer_t *writer, const huffman_tree_t *tree)
+{
+	write_preorder(writer, tree, false);
+}
+
+/*
+ * Écrit la forme de l'arbre en parcours préfixe : 0 pour un noeud, 1 pour une feuille, puis complète l'octet.
+ */
+void huffman_write_tree(huffman_writer_t *writer, const huffman_tree_t *tree)
+{
+	write_preorder(writer, tree, true);
+	huffman_writer_align(writer);
+}
+
+static void write_preorder(huffman_writer_t *writer, const huffman_tree_t *tree, bool shape)
+{
+	uint16_t stack[CHAR_COUNT];
+	uint16_t depth = 0;
+
+	stack[depth++] = tree->root;
+	while (depth > 0)
+	{
+		const huffman_node_t *node = &tree->nodes[stack[--depth]];
+		if (node->type == kHuffmanNodeLeaf)
+		{
+			if (shape)
+				huffman_writer_put(writer, 1, 1);
+			else
+				huffman_writer_put(writer, node->u.leaf.c, 8);
+		}
+		else
+		{
+			if (shape)
+				huffman_writer_put(writer, 0, 1);
+			stack[depth++] = node->u.node.right_child;
+			stack[depth++] = node->u.node.left_child;
+		}
+	}
+}
+
+/*
+ * Entête d'un arbre : 2 octets dont la somme est le nombre de feuilles, les feuilles dans l'ordre de l'arbre puis la
+ * forme de l'arbre complétée jusqu'à l'octet.
+ */
+bool huffman_read_header(huffman_reader_t *reader, huffman_state_t *state)
+{
+	bool seen[CHAR_COUNT] = {false};
+
+	huffman_reader_refill(reader);
+	state->num_leaves = (reader->bits >> 56) + (reader->bits >> 48 & 0xff);
+	huffman_reader_consume(reader, 16);
+	if (state->num_leaves == 0 || state->num_leaves > CHAR_COUNT)
+	{
+		huffman_error_set("Nombre de feuilles invalide (%d).", state->num_leaves);
+		return false;
+	}
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+	{
+		huffman_reader_refill(reader);
+		uint8_t c = reader->bits >> 56;
+		huffman_reader_consume(reader, 8);
+		if (seen[c])
+		{
+			huffman_error_set("Feuille %d en double.", c);
+			return false;
+		}
+		seen[c] = true;
+		state->leaves[i] = c;
+	}
+	return read_tree(reader, state) && read_padding(reader);
+}
+
+/*
+ * La forme de l'arbre est un parcours préfixe : 0 pour un noeud, 1 pour une feuille. Les noeuds en attente de leur
+ * fils droit sont gardés dans une pile. Un arbre de num_leaves feuilles a exactement num_leaves - 1 noeuds, sa forme
+ * 2 * num_leaves - 1 bits : elle est refusée si elle se referme avant la dernière feuille, ou s'il reste des noeuds
+ * sans fils à la dernière.
+ */
+static bool read_tree(huffman_reader_t *reader, huffman_state_t *state)
+{
+	uint16_t stack[CHAR_COUNT];
+	uint16_t depth = 0;
+	uint16_t leaf = 0;
+	uint16_t next = CHAR_COUNT;
+	bool has_root = false;
+
+	while (leaf < state->num_leaves && (depth > 0 || !has_root))
+	{
+		huffman_reader_refill(reader);
+		bool is_leaf = reader->bits >> 63;
+		huffman_reader_consume(reader, 1);
+
+		uint16_t node;
+		if (is_leaf)
+		{
+			node = state->leaves[leaf++];
+			huffman_node_init_leaf(&state->tree.nodes[node], node, HUFFMAN_NODE_NONE);
+		}
+		else
+		{
+			if (depth == CHAR_COUNT - 1 || next == 2 * CHAR_COUNT - 1)
+				break;
+			node = next++;
+			huffman_node_init_node(&state->tree.nodes[node], HUFFMAN_NODE_NONE, HUFFMAN_NODE_NONE, 0,
+			                       HUFFMAN_NODE_NONE);
+		}
+
+		if (depth > 0)
+		{
+			huffman_node_t *parent = &state->tree.nodes[stack[depth - 1]];
+			state->tree.nodes[node].parent = stack[depth - 1];
+			if (parent->u.node.left_child == HUFFMAN_NODE_NONE)
+			{
+				parent->u.node.left_child = node;
+			}
+			else
+			{
+				parent->u.node.right_child = node;
+				depth--;
+			}
+		}
+		else
+		{
+			state->tree.root = node;
+			has_root = true;
+		}
+		if (!is_leaf)
+			stack[depth++] = node;
+	}
+	if (leaf < state->num_leaves || depth != 0)
+	{
+		huffman_error_set("Arbre invalide dans l'entête.");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Entête d'un codage canonique : le plus petit et le plus grand caractère présents sur 1 octet chacun, puis la longueur
+ * du codage de chaque caractère entre les deux sur 4 bits (0 pour un caractère absent), complétée jusqu'à l'octet.
+ */
+void huffman_write_lengths(huffman_writer_t *writer, const huffman_state_t *state,
+                           const huffman_code_t code[CHAR_COUNT])
+{
+	bool present[CHAR_COUNT] = {false};
+	uint16_t first = CHAR_COUNT - 1;
+	uint16_t last = 0;
+
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+	{
+		present[state->leaves[i]] = true;
+		first = state->leaves[i] < first ? state->leaves[i] : first;
+		last = state->leaves[i] > last ? state->leaves[i] : last;
+	}
+	huffman_writer_put(writer, first, 8);
+	huffman_writer_put(writer, last, 8);
+	for (uint16_t c = first; c <= last; c++)
+		huffman_writer_put(writer, present[c] ? code[c].length : 0, 4);
+	huffman_writer_align(writer);
+}
+
+/*
+ * Lit un entête écrit par huffman_write_lengths() : length reçoit la longueur du codage de chaque caractère.
+ */
+bool huffman_read_lengths(huffman_reader_t *reader, uint8_t length[CHAR_COUNT])
+{
+	memset(length, 0, CHAR_COUNT);
+	uint16_t first = huffman_reader_get(reader, 8);
+	uint16_t last = huffman_reader_get(reader, 8);
+	for (uint16_t c = first; c <= last; c++)
+		length[c] = huffman_reader_get(reader, 4);
+	return read_padding(reader);
+}
+
+/*
+ * Termine un entête : les bits qui le complètent jusqu'à l'octet sont nuls, comme les écrit huffman_writer_align().
+ */
+static bool read_padding(huffman_reader_t *reader)
+{
+	uint8_t padding = reader->count & 7;
+	bool zero = padding == 0 || reader->bits >> (64 - padding) == 0;
+	huffman_reader_align(reader);
+	if (huffman_reader_truncated(reader))
+	{
+		huffman_error_set("Entête tronquée.");
+		return false;
+	}
+	if (!zero)
+	{
+		huffman_error_set("Bits de remplissage non nuls dans l'entête.");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Reconstruit l'arbre du codage canonique donné par ses longueurs, pour que le décodage reste celui des blocs avec
+ * arbre. Les longueurs doivent former un codage complet (égalité de Kraft), sauf pour un caractère seul codé sur 1 bit.
+ */
+bool huffman_build_canonical(huffman_state_t *state, const uint8_t length[CHAR_COUNT])
+{
+	huffman_code_t code[CHAR_COUNT];
+	uint32_t kraft = 0;
+	uint16_t next = CHAR_COUNT;
+
+	state->num_leaves = 0;
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		if (length[c] == 0)
+			continue;
+		kraft += (uint32_t)1 << (HUFFMAN_CODE_LENGTH_MAX - length[c]);
+		state->leaves[state->num_leaves++] = c;
+	}
+	if (state->num_leaves == 1 && length[state->leaves[0]] == 1)
+	{
+		state->tree.root = state->leaves[0];
+		huffman_node_init_leaf(&state->tree.nodes[state->tree.root], state->tree.root, HUFFMAN_NODE_NONE);
+		return true;
+	}
+	if (state->num_leaves < 2 || kraft != (uint32_t)1 << HUFFMAN_CODE_LENGTH_MAX)
+	{
+		huffman_error_set("Longueurs de codage invalides dans l'entête.");
+		return false;
+	}
+
+	huffman_canonical_code(code, length);
+	state->tree.root = next++;
+	huffman_node_init_node(&state->tree.nodes[state->tree.root], HUFFMAN_NODE_NONE, HUFFMAN_NODE_NONE, 0,
+	                       HUFFMAN_NODE_NONE);
+	for (uint16_t i = 0; i < state->num_leaves; i++)
+	{
+		uint8_t c = state->leaves[i];
+		if (!insert_code(&state->tree, &next, c, code[c]))
+		{
+			huffman_error_set("Longueurs de codage invalides dans l'entête.");
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Descend depuis la racine en suivant les bits du codage, en créant les noeuds manquants, et accroche la feuille c.
+ */
+static bool insert_code(huffman_tree_t *tree, uint16_t *next, uint8_t c, huffman_code_t code)
+{
+	uint16_t node = tree->root;
+
+	for (uint8_t bit = code.length; bit-- > 0;)
+	{
+		huffman_node_t *parent = &tree->nodes[node];
+		if (parent->type != kHuffmanNodeNode)
+			return false;
+		uint16_t *child = code.bits >> bit & 1 ? &parent->u.node.right_child : &parent->u.node.left_child;
+		if (bit == 0)
+		{
+			if (*child != HUFFMAN_NODE_NONE)
+				return false;
+			*child = c;
+			huffman_node_init_leaf(&tree->nodes[c], c, node);
+		}
+		else if (*child == HUFFMAN_NODE_NONE)
+		{
+			if (*next == 2 * CHAR_COUNT - 1)
+				return false;
+			*child = (*next)++;
+			huffman_node_init_node(&tree->nodes[*child], HUFFMAN_NODE_NONE, HUFFMAN_NODE_NONE, 0, node);
+		}
+		node = *child;
+	}
+	return true;
+}
@@ -0,0 +1,143 @@
+#include "huffman/histogram.h"
+#include "huffman/checksum.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define HISTOGRAM_SSE42
+#endif
+
+#define HISTOGRAM_TABLES 4
+/*
+ * Nombre maximal d'octets comptés avant de vider les tables de 32 bits dans les compteurs de 64 bits.
+ */
+#define HISTOGRAM_CHUNK ((size_t)1 << 30)
+
+static void count_chunk(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT], const uint8_t *data, size_t size);
+static uint32_t count_chunk_crc32c(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT], uint32_t crc, const uint8_t *data,
+                                   size_t size);
+#ifdef HISTOGRAM_SSE42
+static uint32_t count_chunk_sse42(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT], uint32_t crc, const uint8_t *data,
+                                  size_t size);
+#endif
+static void add_tables(uint64_t count[CHAR_COUNT], uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT]);
+
+/*
+ * Ajoute à count le nombre d'occurrences de chaque caractère de data. Les octets sont répartis entre plusieurs tables
+ * pour que deux incréments consécutifs du même caractère ne dépendent pas l'un de l'autre ; les tables sont
+ * additionnées à la fin de chaque tranche de HISTOGRAM_CHUNK octets, ce qui évite tout débordement.
+ */
+void huffman_histogram(uint64_t count[CHAR_COUNT], const uint8_t *data, size_t size)
+{
+	uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT];
+
+	while (size > 0)
+	{
+		size_t n = size < HISTOGRAM_CHUNK ? size : HISTOGRAM_CHUNK;
+		memset(tables, 0, sizeof(tables));
+		count_chunk(tables, data, n);
+		add_tables(count, tables);
+		data += n, size -= n;
+	}
+}
+
+/*
+ * Comme huffman_histogram(), en renvoyant aussi le CRC-32C de data à la suite de crc (0 pour commencer) : avec
+ * l'instruction crc32 de SSE 4.2, chaque mot de 8 octets est compté et ajouté au CRC dans la même boucle, sans relire
+ * data. Sinon, le CRC est calculé par tranches de HUFFMAN_CHECKSUM_CHUNK octets, juste après les avoir comptées.
+ */
+uint32_t huffman_histogram_crc32c(uint64_t count[CHAR_COUNT], uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT];
+
+	while (size > 0)
+	{
+		size_t n = size < HISTOGRAM_CHUNK ? size : HISTOGRAM_CHUNK;
+		memset(tables, 0, sizeof(tables));
+#ifdef HISTOGRAM_SSE42
+		if (__builtin_cpu_supports("sse4.2"))
+			crc = count_chunk_sse42(tables, crc, data, n);
+		else
+#endif
+			crc = count_chunk_crc32c(tables, crc, data, n);
+		add_tables(count, tables);
+		data += n, size -= n;
+	}
+	return crc;
+}
+
+/*
+ * Lit 8 octets à la fois ; l'ordre des octets dans le mot n'a pas d'importance pour compter.
+ */
+static void count_chunk(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT], const uint8_t *data, size_t size)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		tables[0][word & 0xff]++;
+		tables[1][word >> 8 & 0xff]++;
+		tables[2][word >> 16 & 0xff]++;
+		tables[3][word >> 24 & 0xff]++;
+		tables[0][word >> 32 & 0xff]++;
+		tables[1][word >> 40 & 0xff]++;
+		tables[2][word >> 48 & 0xff]++;
+		tables[3][word >> 56]++;
+	}
+	for (; i < size; i++)
+		tables[0][data[i]]++;
+}
+
+static uint32_t count_chunk_crc32c(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT], uint32_t crc, const uint8_t *data,
+                                   size_t size)
+{
+	for (size_t i = 0; i < size; i += HUFFMAN_CHECKSUM_CHUNK)
+	{
+		size_t n = size - i < HUFFMAN_CHECKSUM_CHUNK ? size - i : HUFFMAN_CHECKSUM_CHUNK;
+		count_chunk(tables, data + i, n);
+		crc = huffman_crc32c(crc, data + i, n);
+	}
+	return crc;
+}
+
+#ifdef HISTOGRAM_SSE42
+/*
+ * count_chunk() avec le CRC : sa chaîne de dépendances (3 cycles par mot) est plus courte que celle des huit
+ * incréments, le CRC ne ralentit pas le comptage.
+ */
+__attribute__((target("sse4.2"))) static uint32_t count_chunk_sse42(uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT],
+                                                                    uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint64_t value = ~crc;
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		value = _mm_crc32_u64(value, word);
+		tables[0][word & 0xff]++;
+		tables[1][word >> 8 & 0xff]++;
+		tables[2][word >> 16 & 0xff]++;
+		tables[3][word >> 24 & 0xff]++;
+		tables[0][word >> 32 & 0xff]++;
+		tables[1][word >> 40 & 0xff]++;
+		tables[2][word >> 48 & 0xff]++;
+		tables[3][word >> 56]++;
+	}
+	for (; i < size; i++)
+	{
+		tables[0][data[i]]++;
+		value = _mm_crc32_u8((uint32_t)value, data[i]);
+	}
+	return ~(uint32_t)value;
+}
+#endif
+
+static void add_tables(uint64_t count[CHAR_COUNT], uint32_t tables[HISTOGRAM_TABLES][CHAR_COUNT])
+{
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		count[c] += (uint64_t)tables[0][c] + tables[1][c] + tables[2][c] + tables[3][c];
+}
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/input.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Projette en mémoire un fichier régulier à partir de sa position courante, avec un conseil de lecture séquentielle.
+ * Pour un tube, un terminal ou si la projection échoue, le fichier sera lu avec stdio : renvoie faux dans ce cas.
+ */
+bool huffman_input_open(huffman_input_t *input, FILE *rfd)
+{
+	struct stat info;
+	long offset = ftell(rfd);
+
+	huffman_input_memory(input, NULL, 0);
+	input->rfd = rfd;
+	if (offset < 0 || fstat(fileno(rfd), &info) != 0 || !S_ISREG(info.st_mode) || (off_t)offset > info.st_size)
+		return false;
+	if (info.st_size > offset)
+	{
+		void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(rfd), 0);
+		if (map == MAP_FAILED)
+			return false;
+		posix_madvise(map, info.st_size, POSIX_MADV_SEQUENTIAL);
+		input->map = map;
+		input->map_size = info.st_size;
+		input->data = (const uint8_t *)map + offset;
+		input->size = info.st_size - offset;
+	}
+	input->rfd = NULL;
+	return true;
+}
+
+void huffman_input_memory(huffman_input_t *input, const uint8_t *data, size_t size)
+{
+	memset(input, 0, sizeof(huffman_input_t));
+	input->data = data;
+	input->size = size;
+}
+
+/*
+ * Renvoie dans *block les size octets suivants au plus : directement dans data sans copie, sinon lus dans buffer.
+ */
+size_t huffman_input_read(huffman_input_t *input, uint8_t *buffer, size_t size, const uint8_t **block)
+{
+	if (input->rfd != NULL)
+	{
+		*block = buffer;
+		return fread(buffer, 1, size, input->rfd);
+	}
+	if (size > input->size - input->pos)
+		size = input->size - input->pos;
+	*block = input->data + input->pos;
+	input->pos += size;
+	return size;
+}
+
+/*
+ * Revient au début de l'entrée pour un second passage.
+ */
+void huffman_input_rewind(huffman_input_t *input)
+{
+	if (input->rfd != NULL)
+		rewind(input->rfd);
+	input->pos = 0;
+}
+
+bool huffman_input_error(const huffman_input_t *input)
+{
+	return input->rfd != NULL && ferror(input->rfd);
+}
+
+void huffman_input_close(huffman_input_t *input)
+{
+	if (input->map != NULL)
+		munmap(input->map, input->map_size);
+	input->map = NULL;
+}
+
+/*
+ * Lit size octets de rfd à partir de offset avec pread(), qui ne déplace pas la position du fichier : plusieurs
+ * threads lisent le même fichier en même temps.
+ */
+bool huffman_input_pread(FILE *rfd, uint8_t *data, uint64_t size, uint64_t offset)
+{
+	int fd = fileno(rfd);
+
+	while (size > 0)
+	{
+		ssize_t n = pread(fd, data, size, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n, size -= n, offset += n;
+	}
+	return true;
+}
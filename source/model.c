@@ -0,0 +1,283 @@
+#include "huffman/model.h"
+#include "huffman/build.h"
+#include "huffman/error.h"
+#include "huffman/header.h"
+#include "huffman/histogram.h"
+#include "huffman/stats.h"
+#include <string.h>
+
+/*
+ * Nombre de passes du regroupement : chacune associe chaque contexte à la table qui code ses caractères en le moins
+ * de bits, puis reconstruit les tables sur les contextes qui les ont rejointes.
+ */
+#define MODEL_ROUNDS 2
+/*
+ * Coût compté pour un caractère absent d'une table : il devra y être ajouté, au prix d'un codage plus long.
+ */
+#define MODEL_MISSING_LENGTH (HUFFMAN_CODE_LENGTH_MAX + 1)
+
+static void assign(const huffman_model_t *model, uint16_t cluster[CHAR_COUNT], const uint64_t total[CHAR_COUNT]);
+static void build_tables(huffman_model_t *model, uint16_t cluster[CHAR_COUNT], uint8_t max_length);
+static void build_table(huffman_model_table_t *table, const uint64_t count[CHAR_COUNT], uint8_t max_length);
+
+/*
+ * Alloue un modèle d'au moins count tables, s'il n'y en a pas déjà un assez grand. Le contenu n'est pas conservé ;
+ * les histogrammes sont remis à zéro, puis huffman_model_prepare() ne vide que ceux qu'il a remplis.
+ */
+bool huffman_model_reserve(huffman_model_t **model, const huffman_allocator_t *allocator, uint16_t count)
+{
+	if (*model != NULL && count <= (*model)->capacity)
+		return true;
+	huffman_free(allocator, *model);
+	*model = huffman_alloc(allocator, sizeof(huffman_model_t) + (size_t)count * sizeof(huffman_model_table_t));
+	if (*model == NULL)
+		return false;
+	(*model)->capacity = count;
+	(*model)->count = 0;
+	memset((*model)->counts, 0, sizeof((*model)->counts));
+	return true;
+}
+
+void huffman_model_free(huffman_model_t *model, const huffman_allocator_t *allocator)
+{
+	huffman_free(allocator, model);
+}
+
+/*
+ * Compte les caractères de chaque contexte et les regroupe en au plus tables tables : les contextes les plus
+ * fréquents ont d'abord chacun la leur, les autres les rejoignent pendant MODEL_ROUNDS passes. Une table que tous ses
+ * contextes ont quittée est retirée. *bits reçoit le nombre de bits des caractères codés, *header la taille de
+ * l'entête du modèle.
+ */
+void huffman_model_prepare(huffman_model_t *model, const uint8_t *data, size_t size, unsigned tables,
+                           uint8_t max_length, uint64_t *bits, uint32_t *header)
+{
+	uint64_t total[CHAR_COUNT] = {0};
+	uint16_t cluster[CHAR_COUNT];
+	uint16_t order[CHAR_COUNT];
+	uint16_t used = 0;
+	uint8_t prev = 0;
+
+	HUFFMAN_STATS_START(start);
+	for (size_t i = 0; i < size; i++)
+	{
+		model->counts[prev][data[i]]++;
+		prev = data[i];
+	}
+	/* Chaque caractère sauf le dernier est le contexte du suivant, 0 celui du premier. */
+	huffman_histogram(total, data, size - 1);
+	total[0]++;
+	HUFFMAN_STATS_STOP(kHuffmanStageHistogram, start);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		cluster[c] = CHAR_COUNT;
+		if (total[c] == 0)
+			continue;
+		/* Contextes par nombre de caractères décroissant. */
+		uint16_t i = used++;
+		for (; i > 0 && total[order[i - 1]] < total[c]; i--)
+			order[i] = order[i - 1];
+		order[i] = c;
+	}
+	if (tables > model->capacity)
+		tables = model->capacity;
+	model->count = used < tables ? used : tables;
+	for (uint16_t i = 0; i < model->count; i++)
+		cluster[order[i]] = i;
+	build_tables(model, cluster, max_length);
+	for (uint8_t round = 0; round < MODEL_ROUNDS && used > model->count; round++)
+	{
+		assign(model, cluster, total);
+		build_tables(model, cluster, max_length);
+	}
+
+	*bits = 0;
+	*header = 1 + (model->count > 1 ? CHAR_COUNT : 0);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		model->map[c] = cluster[c] < model->count ? cluster[c] : 0;
+		if (total[c] == 0)
+			continue;
+		const huffman_code_t *code = model->tables[model->map[c]].code;
+		for (uint16_t s = 0; s < CHAR_COUNT; s++)
+			*bits += (uint64_t)model->counts[c][s] * code[s].length;
+		memset(model->counts[c], 0, sizeof(model->counts[c]));
+	}
+	for (uint16_t t = 0; t < model->count; t++)
+	{
+		const huffman_state_t *state = &model->tables[t].state;
+		uint16_t first = CHAR_COUNT - 1;
+		uint16_t last = 0;
+		for (uint16_t i = 0; i < state->num_leaves; i++)
+		{
+			first = state->leaves[i] < first ? state->leaves[i] : first;
+			last = state->leaves[i] > last ? state->leaves[i] : last;
+		}
+		*header += 2 + (last - first + 2) / 2;
+	}
+}
+
+/*
+ * Associe chaque contexte présent à la table qui code ses caractères en le moins de bits. Seuls les caractères
+ * présents dans le contexte sont parcourus.
+ */
+static void assign(const huffman_model_t *model, uint16_t cluster[CHAR_COUNT], const uint64_t total[CHAR_COUNT])
+{
+	uint8_t symbols[CHAR_COUNT];
+
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		const uint32_t *count = model->counts[c];
+		uint64_t best = UINT64_MAX;
+		uint16_t n = 0;
+		if (total[c] == 0)
+			continue;
+		for (uint16_t s = 0; s < CHAR_COUNT; s++)
+			if (count[s] != 0)
+				symbols[n++] = s;
+		for (uint16_t t = 0; t < model->count; t++)
+		{
+			const huffman_code_t *code = model->tables[t].code;
+			uint64_t cost = 0;
+			for (uint16_t i = 0; i < n; i++)
+			{
+				uint8_t length = code[symbols[i]].length;
+				cost += (uint64_t)count[symbols[i]] * (length != 0 ? length : MODEL_MISSING_LENGTH);
+			}
+			if (cost < best)
+			{
+				best = cost;
+				cluster[c] = t;
+			}
+		}
+	}
+}
+
+/*
+ * Construit chaque table sur la somme des histogrammes de ses contextes. Les tables sans contexte sont retirées et
+ * les suivantes renumérotées ; cluster[c] vaut CHAR_COUNT pour un contexte sans table.
+ */
+static void build_tables(huffman_model_t *model, uint16_t cluster[CHAR_COUNT], uint8_t max_length)
+{
+	uint16_t count = 0;
+
+	for (uint16_t t = 0; t < model->count; t++)
+	{
+		uint64_t freq[CHAR_COUNT] = {0};
+		bool empty = true;
+		for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		{
+			if (cluster[c] != t)
+				continue;
+			empty = false;
+			cluster[c] = count;
+			for (uint16_t s = 0; s < CHAR_COUNT; s++)
+				freq[s] += model->counts[c][s];
+		}
+		if (!empty)
+			build_table(&model->tables[count++], freq, max_length);
+	}
+	model->count = count;
+}
+
+static void build_table(huffman_model_table_t *table, const uint64_t count[CHAR_COUNT], uint8_t max_length)
+{
+	uint8_t length[CHAR_COUNT];
+
+	huffman_state_init(&table->state);
+	huffman_set_frequencies(&table->state, count);
+	huffman_build(&table->state);
+	huffman_code_lengths(length, &table->state, max_length);
+	huffman_canonical_code(table->code, length);
+}
+
+void huffman_model_write(const huffman_model_t *model, huffman_writer_t *writer, const uint8_t *data, size_t size)
+{
+	const huffman_code_t *code[CHAR_COUNT];
+	uint8_t prev = 0;
+
+	huffman_writer_put(writer, model->count - 1, 8);
+	if (model->count > 1)
+		for (uint16_t c = 0; c < CHAR_COUNT; c++)
+			huffman_writer_put(writer, model->map[c], 8);
+	for (uint16_t t = 0; t < model->count; t++)
+		huffman_write_lengths(writer, &model->tables[t].state, model->tables[t].code);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		code[c] = model->tables[model->map[c]].code;
+	for (size_t i = 0; i < size; i++)
+	{
+		huffman_writer_put(writer, code[prev][data[i]].bits, code[prev][data[i]].length);
+		prev = data[i];
+	}
+	huffman_writer_align(writer);
+}
+
+/*
+ * Lit l'entête d'un modèle et construit la table de décodage de chacune de ses tables. *model est agrandi si le bloc
+ * a plus de tables qu'il ne peut en contenir.
+ */
+bool huffman_model_read(huffman_model_t **model, const huffman_allocator_t *allocator, huffman_reader_t *reader)
+{
+	uint8_t length[CHAR_COUNT];
+	uint16_t count = huffman_reader_get(reader, 8) + 1;
+
+	if (!huffman_model_reserve(model, allocator, count))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	(*model)->count = count;
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+	{
+		(*model)->map[c] = count > 1 ? huffman_reader_get(reader, 8) : 0;
+		if ((*model)->map[c] >= count)
+		{
+			huffman_error_set("Table de contexte invalide (%d).", (*model)->map[c]);
+			return false;
+		}
+	}
+	for (uint16_t t = 0; t < count; t++)
+	{
+		huffman_model_table_t *table = &(*model)->tables[t];
+		if (!huffman_read_lengths(reader, length) || !huffman_build_canonical(&table->state, length))
+			return false;
+		huffman_decode_table_build(&table->table, &table->state.tree);
+	}
+	return true;
+}
+
+/*
+ * Décode count caractères dans data ; *last est le caractère qui précède data, et reçoit le dernier caractère décodé.
+ * Les codages canoniques ont au plus HUFFMAN_CODE_LENGTH_MAX bits : ils sont tous dans la table principale ou dans
+ * une sous-table, sans parcours de l'arbre. Renvoie faux si l'entrée se termine avant.
+ */
+bool huffman_model_decode(const huffman_model_t *model, huffman_reader_t *reader, uint8_t *data, size_t count,
+                          uint8_t *last)
+{
+	const huffman_decode_entry_t *entries[CHAR_COUNT];
+	uint8_t *end = data + count;
+	uint8_t c = *last;
+
+	for (uint16_t i = 0; i < CHAR_COUNT; i++)
+		entries[i] = model->tables[model->map[i]].table.entries;
+	while (data < end)
+	{
+		huffman_reader_refill(reader);
+		while (reader->count >= HUFFMAN_CODE_LENGTH_MAX && data < end)
+		{
+			const huffman_decode_entry_t *table = entries[c];
+			huffman_decode_entry_t entry = table[reader->bits >> (64 - HUFFMAN_DECODE_ROOT_BITS)];
+			if (entry.type == kHuffmanEntryTable)
+			{
+				huffman_reader_consume(reader, HUFFMAN_DECODE_ROOT_BITS);
+				entry = table[entry.value + (reader->bits >> (64 - entry.length))];
+			}
+			huffman_reader_consume(reader, entry.length);
+			*data++ = c = entry.value;
+		}
+		if (huffman_reader_truncated(reader))
+			return false;
+	}
+	*last = c;
+	return true;
+}
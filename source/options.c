@@ -0,0 +1,48 @@
+#include "huffman/options.h"
+#include "huffman/error.h"
+#include "huffman/limits.h"
+
+void huffman_options_init(huffman_options_t *options)
+{
+	options->block_size = HUFFMAN_BLOCK_SIZE_DEFAULT;
+	options->threads = 1;
+	options->max_code_length = HUFFMAN_CODE_LENGTH_MAX;
+	options->allocator = NULL;
+	options->dictionary = NULL;
+	options->stats = NULL;
+	options->seekable = false;
+	options->streams = 1;
+	options->contexts = 0;
+	options->split = 0;
+}
+
+bool huffman_options_check(const huffman_options_t *options)
+{
+	if (options->block_size < HUFFMAN_BLOCK_SIZE_MIN || options->block_size > HUFFMAN_BLOCK_SIZE_MAX)
+	{
+		huffman_error_set("Taille de bloc invalide (%zu).", options->block_size);
+		return false;
+	}
+	if (options->max_code_length != 0 &&
+	    (options->max_code_length < HUFFMAN_CODE_LENGTH_MIN || options->max_code_length > HUFFMAN_CODE_LENGTH_MAX))
+	{
+		huffman_error_set("Longueur de codage maximale invalide (%u).", options->max_code_length);
+		return false;
+	}
+	if (options->streams == 0 || options->streams > HUFFMAN_STREAMS_MAX)
+	{
+		huffman_error_set("Nombre de flux invalide (%u).", options->streams);
+		return false;
+	}
+	if (options->contexts > HUFFMAN_CONTEXTS_MAX)
+	{
+		huffman_error_set("Nombre de tables de contextes invalide (%u).", options->contexts);
+		return false;
+	}
+	if (options->split > HUFFMAN_SPLIT_MAX)
+	{
+		huffman_error_set("Niveau de découpage invalide (%u).", options->split);
+		return false;
+	}
+	return true;
+}
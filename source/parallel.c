@@ -0,0 +1,576 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/parallel.h"
+#include "huffman/block.h"
+#include "huffman/checksum.h"
+#include "huffman/decode.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/header.h"
+#include "huffman/split.h"
+#include "huffman/stats.h"
+#include <pthread.h>
+#include <string.h>
+
+typedef enum
+{
+	kSlotFree,
+	kSlotReady,
+	kSlotBusy,
+	kSlotDone,
+} slot_status_t;
+
+/*
+ * Un bloc en cours de traitement : le lecteur remplit input, un thread produit output, l'écrivain vide output dans
+ * l'ordre des blocs.
+ */
+typedef struct slot
+{
+	slot_status_t status;
+	uint64_t sequence;      /*!< \brief Numéro du bloc dans le fichier. */
+	bool ok;                /*!< \brief Le traitement du bloc a réussi. */
+	/*! \brief Si le traitement a échoué, message du thread de travail, recopié dans celui de l'appelant. */
+	char error[HUFFMAN_ERROR_SIZE];
+	const uint8_t *source;  /*!< \brief Bloc à compresser : input, ou directement l'entrée projetée. */
+	uint8_t *input;
+	size_t input_size;
+	size_t input_capacity;
+	uint8_t *output;
+	size_t output_size;
+	size_t output_capacity;
+	huffman_block_t block;  /*!< \brief Entête du bloc à décompresser. */
+	/*! \brief Nombre de caractères et taille de chaque bloc compressé dans output (options.split). */
+	huffman_seek_entry_t *blocks;
+	size_t block_count;
+	uint64_t bits;          /*!< \brief Nombre de bits des caractères codés dans output. */
+	uint32_t checksum;      /*!< \brief CRC-32C des caractères du bloc, ou de tous ceux de output. */
+	huffman_frame_t frame;  /*!< \brief Codage réutilisé par un bloc répété. */
+} slot_t;
+
+typedef struct pipeline pipeline_t;
+
+typedef struct worker
+{
+	pthread_t thread;
+	pipeline_t *pipeline;
+	huffman_state_t state;         /*!< \brief État propre au thread. */
+	huffman_decode_table_t table;  /*!< \brief Table de décodage propre au thread. */
+	huffman_model_t *model;        /*!< \brief Tables des blocs d'ordre 1, allouées au premier besoin. */
+	huffman_stats_t stats;         /*!< \brief Compteurs du thread, ajoutés à options->stats à la fin. */
+} worker_t;
+
+typedef bool (*job_t)(worker_t *worker, slot_t *slot);
+typedef bool (*produce_t)(void *arg, slot_t *slot, bool *end);
+typedef bool (*consume_t)(void *arg, const slot_t *slot);
+
+struct pipeline
+{
+	pthread_mutex_t lock;
+	pthread_cond_t ready;  /*!< \brief Un bloc attend un thread, ou stop est vrai. */
+	pthread_cond_t done;   /*!< \brief Un thread a terminé un bloc. */
+	bool stop;
+	slot_t *slots;
+	size_t count;
+	job_t job;
+	const huffman_options_t *options;
+	const huffman_allocator_t *allocator;
+};
+
+typedef struct compress_arg
+{
+	huffman_input_t *input;
+	huffman_writer_t *writer;
+	size_t block_size;
+	huffman_frame_t *frame;
+	huffman_seek_table_t *seek;
+	const huffman_allocator_t *allocator;
+} compress_arg_t;
+
+typedef struct decompress_arg
+{
+	huffman_reader_t *reader;
+	huffman_writer_t *writer;
+	uint32_t block_size;
+	huffman_frame_t *frame;
+	const huffman_dictionary_t *dictionary;
+	const huffman_allocator_t *allocator;
+} decompress_arg_t;
+
+static bool run(const huffman_options_t *options, job_t job, produce_t produce, consume_t consume, void *arg);
+static void *work(void *arg);
+static slot_t *next_ready(pipeline_t *pipeline);
+static bool reserve(const huffman_allocator_t *allocator, uint8_t **data, size_t *capacity, size_t size);
+static bool grow(const huffman_allocator_t *allocator, uint8_t **data, size_t *capacity, size_t used, size_t size);
+static bool compress_job(worker_t *worker, slot_t *slot);
+static bool compress_produce(void *arg, slot_t *slot, bool *end);
+static bool decompress_job(worker_t *worker, slot_t *slot);
+static bool decompress_produce(void *arg, slot_t *slot, bool *end);
+static bool track_code(huffman_frame_t *frame, const huffman_dictionary_t *dictionary, slot_t *slot);
+static bool compress_consume(void *arg, const slot_t *slot);
+static bool decompress_consume(void *arg, const slot_t *slot);
+static bool write_slot(huffman_writer_t *writer, const slot_t *slot);
+
+/*
+ * Les blocs sont compressés indépendamment : aucun n'est un bloc répété, et frame ne garde pas de codage. Chaque bloc
+ * écrit est ajouté à seek s'il n'est pas NULL.
+ */
+bool huffman_compress_parallel(const huffman_options_t *options, huffman_input_t *input, huffman_writer_t *writer,
+                               huffman_frame_t *frame, huffman_seek_table_t *seek)
+{
+	compress_arg_t arg = {.input = input, .writer = writer, .block_size = options->block_size, .frame = frame,
+	                      .seek = seek, .allocator = options->allocator};
+	frame->has_code = false;
+	return run(options, compress_job, compress_produce, compress_consume, &arg);
+}
+
+/*
+ * Le codage des blocs canoniques est suivi dans frame au fil de la lecture, et copié dans l'emplacement de chaque bloc
+ * répété.
+ */
+bool huffman_decompress_parallel(const huffman_options_t *options, huffman_reader_t *reader, uint32_t block_size,
+                                 huffman_writer_t *writer, huffman_frame_t *frame)
+{
+	decompress_arg_t arg = {.reader = reader, .writer = writer, .block_size = block_size, .frame = frame,
+	                        .dictionary = options->dictionary, .allocator = options->allocator};
+	return run(options, decompress_job, decompress_produce, decompress_consume, &arg);
+}
+
+/*
+ * Le thread appelant lit les blocs et les écrit dans l'ordre ; options->threads threads les traitent. Il y a deux
+ * emplacements par thread pour que la lecture et l'écriture avancent pendant le traitement.
+ */
+static bool run(const huffman_options_t *options, job_t job, produce_t produce, consume_t consume, void *arg)
+{
+	const huffman_allocator_t *allocator = options->allocator;
+	pipeline_t pipeline = {.stop = false, .count = 2 * (size_t)options->threads, .job = job, .options = options,
+	                       .allocator = allocator};
+	uint64_t next_read = 0;
+	uint64_t next_write = 0;
+	unsigned started = 0;
+	bool end = false;
+	bool ok = true;
+
+	pipeline.slots = huffman_calloc(allocator, pipeline.count, sizeof(slot_t));
+	worker_t *workers = huffman_calloc(allocator, options->threads, sizeof(worker_t));
+	if (pipeline.slots == NULL || workers == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_free(allocator, pipeline.slots);
+		huffman_free(allocator, workers);
+		return false;
+	}
+	pthread_mutex_init(&pipeline.lock, NULL);
+	pthread_cond_init(&pipeline.ready, NULL);
+	pthread_cond_init(&pipeline.done, NULL);
+	for (; started < options->threads; started++)
+	{
+		workers[started].pipeline = &pipeline;
+		if (pthread_create(&workers[started].thread, NULL, work, &workers[started]) != 0)
+		{
+			huffman_error_set("Création de thread.");
+			ok = false;
+			break;
+		}
+	}
+
+	while (ok && (!end || next_write < next_read))
+	{
+		while (!end && next_read - next_write < pipeline.count)
+		{
+			slot_t *slot = &pipeline.slots[next_read % pipeline.count];
+			if (!(ok = produce(arg, slot, &end)) || end)
+				break;
+			pthread_mutex_lock(&pipeline.lock);
+			slot->sequence = next_read++;
+			slot->status = kSlotReady;
+			pthread_cond_signal(&pipeline.ready);
+			pthread_mutex_unlock(&pipeline.lock);
+		}
+		if (!ok || next_write == next_read)
+			continue;
+
+		slot_t *slot = &pipeline.slots[next_write % pipeline.count];
+		pthread_mutex_lock(&pipeline.lock);
+		while (slot->status != kSlotDone)
+			pthread_cond_wait(&pipeline.done, &pipeline.lock);
+		pthread_mutex_unlock(&pipeline.lock);
+		if (!slot->ok)
+			huffman_error_set("%s", slot->error);
+		ok = slot->ok && consume(arg, slot);
+		pthread_mutex_lock(&pipeline.lock);
+		slot->status = kSlotFree;
+		pthread_mutex_unlock(&pipeline.lock);
+		next_write++;
+	}
+
+	pthread_mutex_lock(&pipeline.lock);
+	pipeline.stop = true;
+	pthread_cond_broadcast(&pipeline.ready);
+	pthread_mutex_unlock(&pipeline.lock);
+	for (unsigned i = 0; i < started; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		if (options->stats != NULL)
+			huffman_stats_merge(options->stats, &workers[i].stats);
+		huffman_model_free(workers[i].model, allocator);
+	}
+	for (size_t i = 0; i < pipeline.count; i++)
+	{
+		huffman_free(allocator, pipeline.slots[i].input);
+		huffman_free(allocator, pipeline.slots[i].output);
+		huffman_free(allocator, pipeline.slots[i].blocks);
+	}
+	pthread_cond_destroy(&pipeline.done);
+	pthread_cond_destroy(&pipeline.ready);
+	pthread_mutex_destroy(&pipeline.lock);
+	huffman_free(allocator, pipeline.slots);
+	huffman_free(allocator, workers);
+	return ok;
+}
+
+static void *work(void *arg)
+{
+	worker_t *worker = arg;
+	pipeline_t *pipeline = worker->pipeline;
+	slot_t *slot = NULL;
+
+	huffman_stats_begin(pipeline->options->stats != NULL ? &worker->stats : NULL);
+	pthread_mutex_lock(&pipeline->lock);
+	for (;;)
+	{
+		while (!pipeline->stop && (slot = next_ready(pipeline)) == NULL)
+			pthread_cond_wait(&pipeline->ready, &pipeline->lock);
+		if (pipeline->stop)
+			break;
+		slot->status = kSlotBusy;
+		pthread_mutex_unlock(&pipeline->lock);
+
+		bool ok = pipeline->job(worker, slot);
+		if (!ok)
+			strcpy(slot->error, huffman_error());
+
+		pthread_mutex_lock(&pipeline->lock);
+		slot->ok = ok;
+		slot->status = kSlotDone;
+		pthread_cond_broadcast(&pipeline->done);
+	}
+	pthread_mutex_unlock(&pipeline->lock);
+	return NULL;
+}
+
+static slot_t *next_ready(pipeline_t *pipeline)
+{
+	slot_t *next = NULL;
+	for (size_t i = 0; i < pipeline->count; i++)
+	{
+		slot_t *slot = &pipeline->slots[i];
+		if (slot->status == kSlotReady && (next == NULL || slot->sequence < next->sequence))
+			next = slot;
+	}
+	return next;
+}
+
+/*
+ * Le contenu précédent n'est pas conservé : il est toujours réécrit entièrement après l'appel.
+ */
+static bool reserve(const huffman_allocator_t *allocator, uint8_t **data, size_t *capacity, size_t size)
+{
+	if (size <= *capacity)
+		return true;
+	huffman_free(allocator, *data);
+	*capacity = 0;
+	if ((*data = huffman_alloc(allocator, size)) == NULL)
+		return false;
+	*capacity = size;
+	return true;
+}
+
+/*
+ * Comme reserve(), en gardant les used premiers octets ; la taille est au moins doublée pour que les blocs d'un même
+ * emplacement ne la fassent pas grandir à chaque fois.
+ */
+static bool grow(const huffman_allocator_t *allocator, uint8_t **data, size_t *capacity, size_t used, size_t size)
+{
+	if (size <= *capacity)
+		return true;
+	if (size < 2 * *capacity)
+		size = 2 * *capacity;
+	uint8_t *grown = huffman_alloc(allocator, size);
+	if (grown == NULL)
+		return false;
+	if (used > 0)
+		memcpy(grown, *data, used);
+	huffman_free(allocator, *data);
+	*data = grown;
+	*capacity = size;
+	return true;
+}
+
+/*
+ * Avec options->split, la tranche de l'emplacement peut donner plusieurs blocs, écrits l'un après l'autre dans output.
+ */
+static bool compress_job(worker_t *worker, slot_t *slot)
+{
+	const huffman_options_t *options = worker->pipeline->options;
+	const huffman_allocator_t *allocator = worker->pipeline->allocator;
+	size_t count = options->block_size / HUFFMAN_SPLIT_WINDOW(options->split) + 1;
+	huffman_writer_t writer;
+
+	if ((options->contexts > 0 && !huffman_model_reserve(&worker->model, allocator, options->contexts)) ||
+	    (slot->blocks == NULL && (slot->blocks = huffman_calloc(allocator, count, sizeof(*slot->blocks))) == NULL))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	slot->block.model = options->contexts > 0 ? worker->model : NULL;
+	slot->output_size = 0;
+	slot->block_count = 0;
+	slot->bits = 0;
+	slot->checksum = 0;
+	for (size_t pos = 0, length; pos < slot->input_size; pos += length)
+	{
+		const uint8_t *data = slot->source + pos;
+		length = huffman_split(data, slot->input_size - pos, options->split);
+		if (!huffman_block_prepare(&worker->state, &slot->block, data, length, options, NULL))
+			return false;
+		size_t size = slot->output_size + HUFFMAN_BLOCK_HEADER_SIZE + slot->block.length;
+		if (!grow(allocator, &slot->output, &slot->output_capacity, slot->output_size, size))
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			return false;
+		}
+		huffman_writer_init(&writer, slot->output + slot->output_size,
+		                    slot->output_capacity - slot->output_size, NULL);
+		huffman_block_write(&worker->state, &slot->block, &writer, data);
+		if (!huffman_writer_finish(&writer))
+			return false;
+		slot->output_size += writer.size;
+		slot->blocks[slot->block_count].size = length;
+		slot->blocks[slot->block_count++].length = slot->block.length;
+		slot->bits += slot->block.bits;
+		slot->checksum = huffman_crc32c_combine(slot->checksum, slot->block.checksum, length);
+	}
+	return true;
+}
+
+static bool compress_produce(void *arg, slot_t *slot, bool *end)
+{
+	compress_arg_t *compress = arg;
+
+	if (compress->input->rfd != NULL &&
+	    !reserve(compress->allocator, &slot->input, &slot->input_capacity, compress->block_size))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	slot->input_size = huffman_input_read(compress->input, slot->input, compress->block_size, &slot->source);
+	*end = slot->input_size == 0;
+	compress->frame->total += slot->input_size;
+	return true;
+}
+
+/*
+ * Le bloc est décodé par tranches de HUFFMAN_CHECKSUM_CHUNK octets, chacune ajoutée au CRC-32C du bloc dès qu'elle est
+ * décodée.
+ */
+static bool decompress_job(worker_t *worker, slot_t *slot)
+{
+	huffman_reader_t reader;
+	huffman_streams_t streams;
+	uint8_t last = 0;
+
+	if (!reserve(worker->pipeline->allocator, &slot->output, &slot->output_capacity, slot->block.size))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	huffman_reader_init_memory(&reader, slot->input, slot->input_size);
+	const huffman_tree_t *tree = &worker->state.tree;
+	const huffman_decode_table_t *table = &worker->table;
+	bool stored = slot->block.type == kHuffmanBlockStored;
+	bool run = slot->block.type == kHuffmanBlockRun;
+	HUFFMAN_STATS_START(start);
+	if (slot->block.type == kHuffmanBlockDictionary)
+	{
+		const huffman_dictionary_t *dictionary = worker->pipeline->options->dictionary;
+		if (huffman_block_read_dictionary(&reader, dictionary, &slot->frame) == NULL)
+			return false;
+		tree = &dictionary->state.tree;
+		table = &dictionary->table;
+	}
+	else if (slot->block.type == kHuffmanBlockContext)
+	{
+		if (!huffman_model_read(&worker->model, worker->pipeline->allocator, &reader))
+			return false;
+	}
+	else if (run)
+	{
+		last = huffman_reader_get(&reader, 8);
+	}
+	else if (!stored)
+	{
+		if (!huffman_block_read_code(&reader, &slot->block, &worker->state, &slot->frame))
+			return false;
+		huffman_decode_table_build(&worker->table, tree);
+	}
+	HUFFMAN_STATS_STOP(kHuffmanStageTable, start);
+	bool interleaved = slot->block.streams != 1;
+	if (interleaved && !huffman_block_read_streams(&reader, &slot->block, &streams, NULL))
+		return false;
+	bool ok = true;
+	slot->checksum = 0;
+	for (size_t pos = 0, n; ok && pos < slot->block.size; pos += n)
+	{
+		uint8_t *data = slot->output + pos;
+		n = slot->block.size - pos < HUFFMAN_CHECKSUM_CHUNK ? slot->block.size - pos : HUFFMAN_CHECKSUM_CHUNK;
+		HUFFMAN_STATS_START(decode);
+		if (slot->block.type == kHuffmanBlockContext)
+		{
+			ok = huffman_model_decode(worker->model, &reader, data, n, &last);
+		}
+		else if (stored)
+		{
+			ok = huffman_reader_bytes(&reader, data, n);
+		}
+		else if (run)
+		{
+			memset(data, last, n);
+			ok = !huffman_reader_truncated(&reader);
+		}
+		else if (interleaved)
+		{
+			ok = huffman_decode_streams(&streams, table, tree, data, n);
+		}
+		else
+		{
+			ok = huffman_decode(&reader, table, tree, data, n);
+		}
+		HUFFMAN_STATS_STOP(kHuffmanStageDecode, decode);
+		HUFFMAN_STATS_START(sum);
+		slot->checksum = huffman_crc32c(slot->checksum, data, n);
+		HUFFMAN_STATS_STOP(kHuffmanStageChecksum, sum);
+	}
+	if (!ok || (interleaved && !huffman_streams_end(&streams)))
+	{
+		huffman_error_set("Bloc tronqué.");
+		return false;
+	}
+	if (!huffman_block_check(&reader, &slot->block, slot->checksum, NULL))
+		return false;
+	huffman_reader_align(&reader);
+	if (huffman_reader_tell(&reader) != (uint64_t)slot->input_size * 8)
+	{
+		huffman_error_set("Taille de bloc compressé incohérente.");
+		return false;
+	}
+	slot->output_size = slot->block.size;
+	return true;
+}
+
+/*
+ * L'entête de chaque bloc donne sa taille compressée : le bloc est copié tel quel, sans être décodé.
+ */
+static bool decompress_produce(void *arg, slot_t *slot, bool *end)
+{
+	decompress_arg_t *decompress = arg;
+
+	if (!huffman_block_read_header(decompress->reader, &slot->block, decompress->block_size))
+		return false;
+	*end = slot->block.size == 0;
+	if (*end)
+		return true;
+	if (!reserve(decompress->allocator, &slot->input, &slot->input_capacity, slot->block.length))
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	slot->input_size = slot->block.length;
+	if (!huffman_reader_bytes(decompress->reader, slot->input, slot->input_size))
+	{
+		huffman_error_set("Fichier tronqué.");
+		return false;
+	}
+	if (!track_code(decompress->frame, decompress->dictionary, slot))
+		return false;
+	decompress->frame->total += slot->block.size;
+	decompress->frame->blocks++;
+	return true;
+}
+
+/*
+ * Un bloc répété dépend du dernier bloc canonique lu : ses longueurs sont relues ici plutôt que dans le thread qui
+ * décode le bloc. Un bloc d'ordre 1 porte tout son modèle ; ni lui ni les blocs
+ * kHuffmanBlockStored et kHuffmanBlockRun ne changent le codage suivi.
+ */
+static bool track_code(huffman_frame_t *frame, const huffman_dictionary_t *dictionary, slot_t *slot)
+{
+	huffman_reader_t reader;
+
+	if (slot->block.type == kHuffmanBlockDictionary)
+	{
+		huffman_reader_init_memory(&reader, slot->input, slot->input_size);
+		return huffman_block_read_dictionary(&reader, dictionary, frame) != NULL;
+	}
+	if (slot->block.type == kHuffmanBlockTree)
+	{
+		frame->has_code = false;
+	}
+	else if (slot->block.type == kHuffmanBlockContext || slot->block.type == kHuffmanBlockStored ||
+	         slot->block.type == kHuffmanBlockRun)
+	{
+		return true;
+	}
+	else if (slot->block.type == kHuffmanBlockCanonical)
+	{
+		huffman_reader_init_memory(&reader, slot->input, slot->input_size);
+		frame->has_code = huffman_read_lengths(&reader, frame->lengths);
+		return frame->has_code;
+	}
+	else if (!frame->has_code)
+	{
+		huffman_error_set("Bloc répété sans codage précédent.");
+		return false;
+	}
+	else
+	{
+		slot->frame = *frame;
+	}
+	return true;
+}
+
+static bool compress_consume(void *arg, const slot_t *slot)
+{
+	compress_arg_t *compress = arg;
+
+	compress->frame->coded += slot->bits;
+	compress->frame->blocks += slot->block_count;
+	compress->frame->checksum = huffman_crc32c_combine(compress->frame->checksum, slot->checksum, slot->input_size);
+	for (size_t i = 0; compress->seek != NULL && i < slot->block_count; i++)
+	{
+		const huffman_seek_entry_t *block = &slot->blocks[i];
+		if (!huffman_seek_table_add(compress->seek, compress->allocator, block->size, block->length))
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			return false;
+		}
+	}
+	return write_slot(compress->writer, slot);
+}
+
+static bool decompress_consume(void *arg, const slot_t *slot)
+{
+	decompress_arg_t *decompress = arg;
+	huffman_frame_t *frame = decompress->frame;
+
+	frame->checksum = huffman_crc32c_combine(frame->checksum, slot->checksum, slot->output_size);
+	return write_slot(decompress->writer, slot);
+}
+
+/*
+ * Une erreur d'écriture est signalée par writer->failed et rapportée par l'appelant.
+ */
+static bool write_slot(huffman_writer_t *writer, const slot_t *slot)
+{
+	huffman_writer_bytes(writer, slot->output, slot->output_size);
+	return !writer->failed;
+}
@@ -0,0 +1,95 @@
+#include "huffman/print.h"
+#include <inttypes.h>
+
+static int node_id(uint16_t node);
+static int left_child(const huffman_node_t *node);
+static int right_child(const huffman_node_t *node);
+
+/*
+ * Rapport d'une compression à partir des compteurs relevés pendant l'appel : rien n'est recalculé. La longueur
+ * moyenne du codage est le nombre de bits des caractères codés divisé par leur nombre.
+ */
+void huffman_report(const huffman_stats_t *stats, huffman_verbosity_t verbosity, FILE *file)
+{
+	if (verbosity == kHuffmanVerbositySilent || stats->bytes_in == 0)
+		return;
+	double ratio = (double)stats->bytes_out / stats->bytes_in * 100;
+	fprintf(file, "\nTaille originelle : %" PRIu64 "\n", stats->bytes_in);
+	fprintf(file, "\nTaille compressée: %" PRIu64 "\n", stats->bytes_out);
+	if (stats->bytes_out > stats->bytes_in)
+		fprintf(file, "\nIl y'a une perte de : %.2f%%\n", ratio - 100);
+	else
+		fprintf(file, "\nIl y'a un gain de : %.2f%%\n", 100 - ratio);
+	if (verbosity < kHuffmanVerbosityDetails)
+		return;
+
+	fprintf(file, "\nBlocs : %" PRIu64 "\n", stats->blocks);
+	if (stats->bits != 0)
+		fprintf(file, "\nLongueur moyenne du codage : %.2f\n", (double)stats->bits / stats->bytes_in);
+#ifdef HUFFMAN_STATS
+	fprintf(file, "\nCaractères différents : %u\n", stats->symbols);
+	fprintf(file, "\nLongueur maximale du codage : %u\n", stats->max_code_length);
+	fprintf(file, "\nAllocations : %" PRIu64 " (%" PRIu64 " octets)\n", stats->allocations, stats->allocated);
+	fprintf(file, "\n%13s%16s\n", "Étape", "Durée (ns)");
+	for (int stage = 0; stage < kHuffmanStageCount; stage++)
+		if (stats->time[stage] != 0)
+			fprintf(file, "%13s%16" PRIu64 "\n", huffman_stats_stage_name(stage), stats->time[stage]);
+#endif
+}
+
+void huffman_print(const huffman_state_t *state, const huffman_code_t code[CHAR_COUNT])
+{
+	const huffman_node_t *nodes = state->tree.nodes;
+	uint16_t root = state->tree.root;
+	uint64_t sum = 0;
+	char buff[65];
+	int i;
+
+	printf("%8s%8s%15s%14s%14s\n", "Noeud", "Pere", "Fils Gauche", "Fils Droit", "Fréquence");
+	printf("%7d%9s%11d%16d%13.4f\n", root, "R", left_child(&nodes[root]), right_child(&nodes[root]),
+	       (float)nodes[root].freq / state->file_size);
+	for (i = root - 1; i >= CHAR_COUNT; i--)
+		printf("%7d%9d%11d%16d%13.4f\n", i, node_id(nodes[i].parent), left_child(&nodes[i]),
+		       right_child(&nodes[i]), (float)nodes[i].freq / state->file_size);
+	if (state->num_leaves > 1)
+	{
+		for (i = 0; i < state->num_leaves; i++)
+		{
+			const huffman_node_t *leaf = &nodes[state->leaves[i]];
+			printf("%7d%9d%11d%16d%13.4f\n", state->leaves[i], node_id(leaf->parent), right_child(leaf),
+			       left_child(leaf), (float)leaf->freq / state->file_size);
+		}
+	}
+	printf("\n");
+	for (i = 2; i < 30; i++)
+		printf("- ");
+
+	printf("\n\n%13s%30s\n", "Caractère", "Codage");
+	for (i = 0; i < state->num_leaves; i++)
+	{
+		const huffman_code_t *current = &code[state->leaves[i]];
+		for (uint8_t j = 0; j < current->length; j++)
+			buff[j] = current->bits >> (current->length - 1 - j) & 1 ? '1' : '0';
+		buff[current->length] = '\0';
+		printf("%9d%32s\n", state->leaves[i], buff);
+	}
+
+	for (i = 0; i < state->num_leaves; i++)
+		sum += (uint64_t)nodes[state->leaves[i]].freq * code[state->leaves[i]].length;
+	printf("\n\nLongueur moyenne du codage : %.2f\n", (float)sum / state->file_size);
+}
+
+static int node_id(uint16_t node)
+{
+	return node == HUFFMAN_NODE_NONE ? -1 : node;
+}
+
+static int left_child(const huffman_node_t *node)
+{
+	return node->type == kHuffmanNodeLeaf ? -1 : node->u.node.left_child;
+}
+
+static int right_child(const huffman_node_t *node)
+{
+	return node->type == kHuffmanNodeLeaf ? -1 : node->u.node.right_child;
+}
@@ -0,0 +1,143 @@
+#include "huffman/reader.h"
+#include "huffman/input.h"
+#include <string.h>
+
+static size_t read_file(huffman_reader_t *reader, uint8_t *data, size_t size);
+
+void huffman_reader_init_file(huffman_reader_t *reader, FILE *rfd, uint8_t *buffer, size_t capacity)
+{
+	memset(reader, 0, sizeof(huffman_reader_t));
+	reader->rfd = rfd;
+	reader->buffer = buffer;
+	reader->capacity = capacity;
+	reader->data = buffer;
+}
+
+/*
+ * Comme huffman_reader_init_file(), l'entrée étant les size octets de rfd à partir de offset, lus avec pread() : la
+ * position du fichier ne change pas, plusieurs lecteurs lisent le même fichier en même temps.
+ */
+void huffman_reader_init_range(huffman_reader_t *reader, FILE *rfd, uint64_t offset, uint64_t size, uint8_t *buffer,
+                               size_t capacity)
+{
+	huffman_reader_init_file(reader, rfd, buffer, capacity);
+	reader->ranged = true;
+	reader->offset = offset;
+	reader->remaining = size;
+}
+
+void huffman_reader_init_memory(huffman_reader_t *reader, const uint8_t *data, size_t size)
+{
+	memset(reader, 0, sizeof(huffman_reader_t));
+	reader->data = data;
+	reader->end = size;
+}
+
+/*
+ * Chemin lent de huffman_reader_refill() : on relit le fichier si besoin, puis on charge octet par octet. Une fois la
+ * fin de l'entrée atteinte, on complète avec des zéros en les comptant dans padding.
+ */
+void huffman_reader_fill(huffman_reader_t *reader)
+{
+	if (reader->rfd != NULL && reader->end - reader->pos < 8)
+	{
+		reader->base += reader->pos;
+		reader->end -= reader->pos;
+		memmove(reader->buffer, reader->buffer + reader->pos, reader->end);
+		reader->pos = 0;
+		reader->end += read_file(reader, reader->buffer + reader->end, reader->capacity - reader->end);
+	}
+	if (reader->end - reader->pos >= 8)
+	{
+		huffman_reader_refill(reader);
+		return;
+	}
+	while (reader->count <= 56)
+	{
+		if (reader->pos < reader->end)
+			reader->bits |= (uint64_t)reader->data[reader->pos++] << (56 - reader->count);
+		else
+			reader->padding += 8;
+		reader->count += 8;
+	}
+}
+
+/*
+ * Position en bits dans l'entrée du prochain bit à lire.
+ */
+uint64_t huffman_reader_tell(const huffman_reader_t *reader)
+{
+	return (reader->base + reader->pos) * 8 + reader->padding - reader->count;
+}
+
+void huffman_reader_align(huffman_reader_t *reader)
+{
+	huffman_reader_consume(reader, reader->count & 7);
+}
+
+/*
+ * Copie size octets à partir d'une position alignée sur l'octet. Les octets déjà chargés dans bits sont copiés en
+ * premier, puis ceux de data, puis le reste est lu directement depuis le fichier.
+ */
+bool huffman_reader_bytes(huffman_reader_t *reader, uint8_t *data, size_t size)
+{
+	while (size > 0 && reader->count >= 8)
+	{
+		*data++ = reader->bits >> 56;
+		huffman_reader_consume(reader, 8);
+		size--;
+		if (huffman_reader_truncated(reader))
+			return false;
+	}
+	if (size == 0)
+		return true;
+	/* bits peut contenir une copie anticipée des octets suivants, qui vont être copiés sans passer par bits. */
+	reader->bits = 0;
+
+	size_t available = reader->end - reader->pos;
+	size_t n = size < available ? size : available;
+	memcpy(data, reader->data + reader->pos, n);
+	reader->pos += n;
+	data += n, size -= n;
+	if (size > 0 && reader->rfd != NULL)
+	{
+		n = read_file(reader, data, size);
+		reader->base += n;
+		size -= n;
+	}
+	return size == 0;
+}
+
+/*
+ * Avance de size octets à partir d'une position alignée sur l'octet et renvoie ces octets : directement dans data si
+ * toute l'entrée est en mémoire, sinon copiés dans scratch. Renvoie NULL si l'entrée se termine avant.
+ */
+const uint8_t *huffman_reader_take(huffman_reader_t *reader, size_t size, uint8_t *scratch)
+{
+	if (reader->rfd != NULL)
+		return huffman_reader_bytes(reader, scratch, size) ? scratch : NULL;
+	size_t pos = huffman_reader_tell(reader) / 8;
+	if (huffman_reader_truncated(reader) || reader->end - pos < size)
+		return NULL;
+	reader->pos = pos + size;
+	reader->bits = 0;
+	reader->count = 0;
+	reader->padding = 0;
+	return reader->data + pos;
+}
+
+/*
+ * Lit au plus size octets de rfd, avec fread() ou dans la plage du lecteur. Une erreur de lecture termine l'entrée.
+ */
+static size_t read_file(huffman_reader_t *reader, uint8_t *data, size_t size)
+{
+	if (!reader->ranged)
+		return fread(data, 1, size, reader->rfd);
+	if (size > reader->remaining)
+		size = reader->remaining;
+	if (!huffman_input_pread(reader->rfd, data, size, reader->offset))
+		return 0;
+	reader->offset += size;
+	reader->remaining -= size;
+	return size;
+}
@@ -0,0 +1,339 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/seekable.h"
+#include "huffman/block.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/input.h"
+#include "huffman/limits.h"
+#include "huffman/reader.h"
+#include <string.h>
+#include <sys/stat.h>
+
+static bool read_index(huffman_seekable_t *seekable, const huffman_allocator_t *allocator, uint64_t end);
+static size_t find_frame(FILE *rfd, uint64_t table, uint64_t length, uint8_t header[HUFFMAN_FRAME_HEADER_SIZE],
+                         uint64_t *start);
+static uint64_t find_block(const huffman_seekable_t *seekable, uint64_t offset);
+static huffman_status_t load_block(huffman_seekable_t *seekable, uint64_t block, const uint8_t **data);
+
+void huffman_seek_table_init(huffman_seek_table_t *table)
+{
+	memset(table, 0, sizeof(huffman_seek_table_t));
+}
+
+bool huffman_seek_table_add(huffman_seek_table_t *table, const huffman_allocator_t *allocator, uint32_t size,
+                            uint32_t length)
+{
+	if (table->count == table->capacity)
+	{
+		uint64_t capacity = table->capacity > 0 ? 2 * table->capacity : 64;
+		huffman_seek_entry_t *entries = huffman_alloc(allocator, capacity * sizeof(huffman_seek_entry_t));
+		if (entries == NULL)
+			return false;
+		if (table->count > 0)
+			memcpy(entries, table->entries, table->count * sizeof(huffman_seek_entry_t));
+		huffman_free(allocator, table->entries);
+		table->entries = entries;
+		table->capacity = capacity;
+	}
+	table->entries[table->count].size = size;
+	table->entries[table->count].length = length;
+	table->count++;
+	return true;
+}
+
+void huffman_seek_table_write(const huffman_seek_table_t *table, huffman_writer_t *writer)
+{
+	for (uint64_t i = 0; i < table->count; i++)
+	{
+		huffman_writer_put(writer, table->entries[i].size, 32);
+		huffman_writer_put(writer, table->entries[i].length, 32);
+	}
+	huffman_writer_put(writer, table->count, 64);
+	for (const char *magic = HUFFMAN_SEEK_MAGIC; *magic != '\0'; magic++)
+		huffman_writer_put(writer, (uint8_t)*magic, 8);
+}
+
+void huffman_seek_table_free(huffman_seek_table_t *table, const huffman_allocator_t *allocator)
+{
+	huffman_free(allocator, table->entries);
+	huffman_seek_table_init(table);
+}
+
+/*
+ * Lit l'index à la fin de rfd, qui doit rester ouvert jusqu'à huffman_seekable_close(). Au plus cache_size blocs
+ * décodés sont gardés (HUFFMAN_SEEK_CACHE_DEFAULT si cache_size vaut 0). options peut être NULL ; le dictionnaire des
+ * blocs kHuffmanBlockDictionary vient de options.
+ */
+huffman_seekable_t *huffman_seekable_open(const huffman_options_t *options, FILE *rfd, size_t cache_size)
+{
+	huffman_options_t defaults;
+	struct stat info;
+
+	if (options == NULL)
+	{
+		huffman_options_init(&defaults);
+		options = &defaults;
+	}
+	if (cache_size == 0)
+		cache_size = HUFFMAN_SEEK_CACHE_DEFAULT;
+	if (fstat(fileno(rfd), &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		huffman_error_set("Fichier sans index de blocs.");
+		return NULL;
+	}
+	huffman_seekable_t *seekable = huffman_calloc(options->allocator, 1, sizeof(huffman_seekable_t));
+	if (seekable == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	seekable->rfd = rfd;
+	seekable->context = huffman_context_new(options);
+	seekable->cache = huffman_calloc(options->allocator, cache_size, sizeof(huffman_seek_slot_t));
+	if (seekable->context == NULL || seekable->cache == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_seekable_close(seekable);
+		return NULL;
+	}
+	seekable->context->options.threads = 1;
+	seekable->cache_size = cache_size;
+	for (size_t i = 0; i < cache_size; i++)
+		seekable->cache[i].block = UINT64_MAX;
+	if (!read_index(seekable, options->allocator, info.st_size))
+	{
+		huffman_seekable_close(seekable);
+		return NULL;
+	}
+	return seekable;
+}
+
+/*
+ * Copie dans dst au plus size caractères à partir du caractère offset, comme pread() : *dst_size reçoit le nombre de
+ * caractères copiés, plus petit que size seulement à la fin du fichier.
+ */
+huffman_status_t huffman_seekable_pread(huffman_seekable_t *seekable, uint8_t *dst, size_t size, uint64_t offset,
+                                        size_t *dst_size)
+{
+	*dst_size = 0;
+	if (offset >= seekable->size)
+		return kHuffmanOk;
+	if (size > seekable->size - offset)
+		size = seekable->size - offset;
+	for (uint64_t block = find_block(seekable, offset); size > 0; block++)
+	{
+		const uint8_t *data;
+		huffman_status_t status = load_block(seekable, block, &data);
+		if (status != kHuffmanOk)
+			return status;
+		size_t n = seekable->offsets[block + 1] - offset;
+		if (n > size)
+			n = size;
+		memcpy(dst, data + (offset - seekable->offsets[block]), n);
+		dst += n, size -= n, offset += n;
+		*dst_size += n;
+	}
+	return kHuffmanOk;
+}
+
+void huffman_seekable_close(huffman_seekable_t *seekable)
+{
+	if (seekable == NULL)
+		return;
+	const huffman_allocator_t *allocator = seekable->context != NULL ? seekable->context->options.allocator : NULL;
+	for (size_t i = 0; seekable->cache != NULL && i < seekable->cache_size; i++)
+		huffman_free(allocator, seekable->cache[i].data);
+	huffman_free(allocator, seekable->cache);
+	huffman_free(allocator, seekable->offsets);
+	huffman_free(allocator, seekable->positions);
+	huffman_free(allocator, seekable->buffer);
+	huffman_context_free(seekable->context);
+	huffman_free(allocator, seekable);
+}
+
+/*
+ * L'index donne la taille de chaque bloc : la trame commence donc à la fin du fichier moins l'index, le résumé, le
+ * bloc de fin et tous les blocs. Son entête et son résumé sont vérifiés avant d'utiliser l'index.
+ */
+static bool read_index(huffman_seekable_t *seekable, const huffman_allocator_t *allocator, uint64_t end)
+{
+	uint8_t footer[HUFFMAN_SEEK_FOOTER_SIZE];
+	uint8_t header[HUFFMAN_FRAME_HEADER_SIZE];
+	uint8_t trailer[1 + HUFFMAN_FRAME_TRAILER_SIZE(HUFFMAN_FORMAT_VERSION)];
+	/* Bloc de fin et plus court des résumés d'une trame qui peut avoir un index. */
+	uint64_t minimum_trailer = 1 + HUFFMAN_FRAME_TRAILER_SIZE(3);
+	huffman_reader_t reader;
+
+	if (end < HUFFMAN_SEEK_FOOTER_SIZE ||
+	    !huffman_input_pread(seekable->rfd, footer, sizeof(footer), end - sizeof(footer)) ||
+	    memcmp(footer + 8, HUFFMAN_SEEK_MAGIC, 4) != 0)
+	{
+		huffman_error_set("Fichier sans index de blocs.");
+		return false;
+	}
+	uint64_t count = huffman_load_be64(footer);
+	uint64_t minimum = HUFFMAN_FRAME_HEADER_SIZE + minimum_trailer + HUFFMAN_SEEK_FOOTER_SIZE;
+	if (end < minimum || count > (end - minimum) / (HUFFMAN_SEEK_ENTRY_SIZE + HUFFMAN_BLOCK_HEADER_SIZE))
+	{
+		huffman_error_set("Index de blocs invalide.");
+		return false;
+	}
+	uint64_t table = end - HUFFMAN_SEEK_FOOTER_SIZE - count * HUFFMAN_SEEK_ENTRY_SIZE;
+	uint64_t space = table - HUFFMAN_FRAME_HEADER_SIZE - minimum_trailer;
+	uint8_t *entries = huffman_alloc(allocator, count * HUFFMAN_SEEK_ENTRY_SIZE + 1);
+	seekable->offsets = huffman_alloc(allocator, (count + 1) * sizeof(uint64_t));
+	seekable->positions = huffman_alloc(allocator, (count + 1) * sizeof(uint64_t));
+	if (entries == NULL || seekable->offsets == NULL || seekable->positions == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		huffman_free(allocator, entries);
+		return false;
+	}
+	bool ok = huffman_input_pread(seekable->rfd, entries, count * HUFFMAN_SEEK_ENTRY_SIZE, table);
+	huffman_reader_init_memory(&reader, entries, count * HUFFMAN_SEEK_ENTRY_SIZE);
+
+	/* Positions relatives au premier bloc, puis décalées une fois le début de la trame connu. */
+	uint64_t length = 0;
+	uint32_t largest = 0;
+	seekable->offsets[0] = 0;
+	for (uint64_t i = 0; ok && i < count; i++)
+	{
+		uint32_t size = huffman_reader_get(&reader, 32);
+		uint32_t body = huffman_reader_get(&reader, 32);
+		ok = size > 0 && size <= HUFFMAN_BLOCK_SIZE_MAX && body <= HUFFMAN_BLOCK_LENGTH_MAX(size) &&
+		     length + HUFFMAN_BLOCK_HEADER_SIZE + body <= space;
+		seekable->positions[i] = length;
+		seekable->offsets[i + 1] = seekable->offsets[i] + size;
+		length += HUFFMAN_BLOCK_HEADER_SIZE + body;
+		largest = body > largest ? body : largest;
+	}
+	huffman_free(allocator, entries);
+	seekable->positions[count] = length;
+	uint64_t start = 0;
+	size_t size = ok ? find_frame(seekable->rfd, table, length, header, &start) : 0;
+	ok = size != 0 && huffman_input_pread(seekable->rfd, trailer, size, table - size) &&
+	     trailer[0] == kHuffmanBlockEnd && huffman_load_be64(trailer + 1) == seekable->offsets[count] &&
+	     huffman_load_be64(trailer + 9) == count;
+	if (!ok)
+	{
+		huffman_error_set("Index de blocs invalide.");
+		return false;
+	}
+	seekable->block_size = (uint32_t)header[5] << 24 | header[6] << 16 | header[7] << 8 | header[8];
+	seekable->size = seekable->offsets[count];
+	seekable->count = count;
+	for (uint64_t i = 0; i <= count; i++)
+	{
+		ok = ok && (i == count || seekable->offsets[i + 1] - seekable->offsets[i] <= seekable->block_size);
+		seekable->positions[i] += start + HUFFMAN_FRAME_HEADER_SIZE;
+	}
+	if (!ok || seekable->block_size > HUFFMAN_BLOCK_SIZE_MAX)
+	{
+		huffman_error_set("Index de blocs invalide.");
+		return false;
+	}
+	seekable->buffer = huffman_alloc(allocator, HUFFMAN_BLOCK_HEADER_SIZE + (size_t)largest);
+	if (seekable->buffer == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Le résumé d'une trame s'allonge avec la version 10, et la version est dans l'entête, que la taille du résumé permet
+ * de trouver : chaque taille de résumé est essayée, jusqu'à trouver un entête dont la version a cette taille. Renvoie
+ * la taille du bloc de fin et du résumé (0 si aucun entête ne convient) ; *start reçoit la position de l'entête.
+ */
+static size_t find_frame(FILE *rfd, uint64_t table, uint64_t length, uint8_t header[HUFFMAN_FRAME_HEADER_SIZE],
+                         uint64_t *start)
+{
+	static const uint8_t versions[] = {HUFFMAN_FORMAT_VERSION, 3};
+
+	for (size_t i = 0; i < sizeof(versions); i++)
+	{
+		size_t size = 1 + HUFFMAN_FRAME_TRAILER_SIZE(versions[i]);
+		if (table < HUFFMAN_FRAME_HEADER_SIZE + length + size)
+			continue;
+		*start = table - size - length - HUFFMAN_FRAME_HEADER_SIZE;
+		if (!huffman_input_pread(rfd, header, HUFFMAN_FRAME_HEADER_SIZE, *start))
+			return 0;
+		uint8_t version = header[HUFFMAN_MAGIC_SIZE];
+		if (memcmp(header, HUFFMAN_MAGIC, HUFFMAN_MAGIC_SIZE) == 0 && version >= 3 &&
+		    version <= HUFFMAN_FORMAT_VERSION && 1 + HUFFMAN_FRAME_TRAILER_SIZE(version) == size)
+			return size;
+	}
+	return 0;
+}
+
+/*
+ * Dernier bloc dont le premier caractère est avant offset (offset < size).
+ */
+static uint64_t find_block(const huffman_seekable_t *seekable, uint64_t offset)
+{
+	uint64_t low = 0, high = seekable->count - 1;
+
+	while (low < high)
+	{
+		uint64_t middle = low + (high - low + 1) / 2;
+		if (seekable->offsets[middle] <= offset)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+/*
+ * Renvoie dans *data les caractères décodés de block, depuis le cache ou en décodant le bloc dans l'emplacement le
+ * moins récemment utilisé.
+ */
+static huffman_status_t load_block(huffman_seekable_t *seekable, uint64_t block, const uint8_t **data)
+{
+	const huffman_allocator_t *allocator = seekable->context->options.allocator;
+	huffman_seek_slot_t *slot = &seekable->cache[0];
+	size_t size;
+
+	for (size_t i = 0; i < seekable->cache_size; i++)
+	{
+		if (seekable->cache[i].block == block)
+		{
+			slot = &seekable->cache[i];
+			slot->used = ++seekable->clock;
+			*data = slot->data;
+			return kHuffmanOk;
+		}
+		if (seekable->cache[i].used < slot->used)
+			slot = &seekable->cache[i];
+	}
+	if (slot->data == NULL && (slot->data = huffman_alloc(allocator, seekable->block_size)) == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return kHuffmanErrorMemory;
+	}
+	slot->block = UINT64_MAX;
+	slot->used = 0;
+	uint64_t length = seekable->positions[block + 1] - seekable->positions[block];
+	if (!huffman_input_pread(seekable->rfd, seekable->buffer, length, seekable->positions[block]))
+	{
+		huffman_error_set("Lecture du fichier (pread).");
+		return kHuffmanErrorData;
+	}
+	huffman_context_reset(seekable->context);
+	huffman_status_t status = huffman_context_decompress_block(seekable->context, seekable->block_size,
+	                                                           seekable->buffer, length, slot->data,
+	                                                           seekable->block_size, &size);
+	if (status != kHuffmanOk)
+		return status;
+	if (size != seekable->offsets[block + 1] - seekable->offsets[block])
+	{
+		huffman_error_set("Index de blocs invalide.");
+		return kHuffmanErrorData;
+	}
+	slot->block = block;
+	slot->used = ++seekable->clock;
+	*data = slot->data;
+	return kHuffmanOk;
+}
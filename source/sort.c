@@ -1,45 +1,69 @@
 #include "huffman/sort.h"
-#include <stdbool.h>
 #include <stdint.h>
 
-static void sift(huffman_state_t *state, uint16_t *array, uint16_t pos, uint16_t size);
-static bool freq_less(huffman_state_t *state, uint16_t i, uint16_t j);
+/* En dessous, le tri par insertion coûte moins que les histogrammes du tri par base. */
+#define SORT_INSERTION_MAX 48
 
-void huffman_heapsort(huffman_state_t *state, uint16_t *array, uint16_t size)
-{
-	int i, tmp;
-
-	for (i = size / 2; i >= 0; i--)
-		sift(state, array, i, size);
-	for (i = size; i > 0; i--)
-	{
-		tmp = array[i], array[i] = array[0], array[0] = tmp;
-		sift(state, array, 0, i - 1);
-	}
-}
+static void insertion_sort(uint64_t *keys, uint16_t size);
 
-static void sift(huffman_state_t *state, uint16_t *array, uint16_t pos, uint16_t size)
+/*
+ * Trie state->leaves par fréquence croissante, puis par valeur croissante à fréquence égale, et range dans freq la
+ * fréquence de chaque feuille triée. Chaque feuille devient une clé de 64 bits, sa fréquence suivie de sa valeur sur
+ * l'octet de poids faible : le tri ne lit et ne déplace que ces clés, dans un tableau contigu, sans passer par les
+ * noeuds de l'arbre. Le tri par base ne fait une passe que sur les octets de la fréquence qui ne sont pas les mêmes
+ * pour toutes les clés ; il est stable et garde l'ordre de state->leaves à fréquence égale, qui doit donc être rangé
+ * par valeur croissante (huffman_set_frequencies()).
+ */
+void huffman_sort_leaves(huffman_state_t *state, uint32_t freq[CHAR_COUNT])
 {
-	int j, tmp;
+	uint64_t keys[CHAR_COUNT], other[CHAR_COUNT];
+	uint64_t *src = keys, *dst = other;
+	uint16_t size = state->num_leaves;
 
-	j = 2 * pos;
-	while (j <= size)
+	for (uint16_t i = 0; i < size; i++)
+		keys[i] = (uint64_t)state->tree.nodes[state->leaves[i]].freq << 8 | state->leaves[i];
+	if (size <= SORT_INSERTION_MAX)
+		insertion_sort(keys, size);
+	else
 	{
-		if (j < size && freq_less(state, j, j + 1))
-			j++;
-		if (freq_less(state, pos, j))
+		uint64_t varying = 0;
+		for (uint16_t i = 1; i < size; i++)
+			varying |= keys[i] ^ keys[0];
+		for (uint8_t shift = 8; shift < 40; shift += 8)
 		{
-			tmp = array[pos], array[pos] = array[j], array[j] = tmp;
-			pos = j, j = 2 * pos;
+			uint16_t count[CHAR_COUNT] = {0};
+			uint16_t pos = 0;
+			if ((varying >> shift & 0xff) == 0)
+				continue;
+			for (uint16_t i = 0; i < size; i++)
+				count[src[i] >> shift & 0xff]++;
+			for (uint16_t d = 0; d < CHAR_COUNT; d++)
+			{
+				uint16_t n = count[d];
+				count[d] = pos;
+				pos += n;
+			}
+			for (uint16_t i = 0; i < size; i++)
+				dst[count[src[i] >> shift & 0xff]++] = src[i];
+			uint64_t *tmp = src;
+			src = dst, dst = tmp;
 		}
-		else
-			j = size + 1;
+	}
+	for (uint16_t i = 0; i < size; i++)
+	{
+		state->leaves[i] = src[i] & 0xff;
+		freq[i] = src[i] >> 8;
 	}
 }
 
-static bool freq_less(huffman_state_t *state, uint16_t i, uint16_t j)
+static void insertion_sort(uint64_t *keys, uint16_t size)
 {
-	uint32_t freq_i = state->tree.nodes[state->leaves[i]].freq;
-	uint32_t freq_j = state->tree.nodes[state->leaves[j]].freq;
-	return freq_i < freq_j;
+	for (uint16_t i = 1; i < size; i++)
+	{
+		uint64_t key = keys[i];
+		uint16_t j = i;
+		for (; j > 0 && keys[j - 1] > key; j--)
+			keys[j] = keys[j - 1];
+		keys[j] = key;
+	}
 }
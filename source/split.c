@@ -0,0 +1,70 @@
+#include "huffman/split.h"
+#include "huffman/block.h"
+#include "huffman/histogram.h"
+#include "huffman/stats.h"
+#include <math.h>
+#include <string.h>
+
+/*
+ * Gain minimal, en bits, pour commencer un nouveau bloc : son entête et sa somme de contrôle, et des longueurs
+ * canoniques pour la moitié des caractères.
+ */
+#define SPLIT_BLOCK_BITS (8 * (HUFFMAN_BLOCK_HEADER_SIZE + HUFFMAN_BLOCK_CHECKSUM_SIZE + 2 + CHAR_COUNT / 4))
+
+static double weight(uint64_t count);
+
+/*
+ * Renvoie le nombre de caractères du premier bloc de data (size si level vaut 0). Le bloc avance par fenêtres de
+ * HUFFMAN_SPLIT_WINDOW(level) caractères : chaque fenêtre est comparée à l'histogramme du bloc, et le bloc s'arrête
+ * devant elle si la coder avec son propre codage plutôt qu'avec celui du bloc gagne plus de SPLIT_BLOCK_BITS bits.
+ * Les coûts sont estimés par l'entropie : H(a) = n log2 n - somme des a[c] log2 a[c] bits pour un histogramme a de n
+ * caractères, et le gain vaut H(bloc + fenêtre) - H(bloc) - H(fenêtre). Seuls les caractères présents dans la fenêtre
+ * y contribuent ; le poids a[c] log2 a[c] de ceux du bloc est gardé d'une fenêtre à l'autre. Un niveau plus élevé
+ * coupe plus près des changements et permet des blocs plus courts, au prix de plus de fenêtres.
+ */
+size_t huffman_split(const uint8_t *data, size_t size, unsigned level)
+{
+	uint64_t block[CHAR_COUNT] = {0};
+	uint64_t window[CHAR_COUNT];
+	double weights[CHAR_COUNT];
+	double merged[CHAR_COUNT];
+	size_t step = HUFFMAN_SPLIT_WINDOW(level);
+	size_t pos = step;
+
+	if (level == 0 || size < 2 * step)
+		return size;
+	HUFFMAN_STATS_START(start);
+	huffman_histogram(block, data, step);
+	for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		weights[c] = weight(block[c]);
+	for (; size - pos >= step; pos += step)
+	{
+		double gain = weight(pos + step) - weight(pos) - weight(step);
+		memset(window, 0, sizeof(window));
+		huffman_histogram(window, data + pos, step);
+		for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		{
+			if (window[c] == 0)
+				continue;
+			merged[c] = weight(block[c] + window[c]);
+			gain -= merged[c] - weights[c] - weight(window[c]);
+		}
+		if (gain > SPLIT_BLOCK_BITS)
+			break;
+		for (uint16_t c = 0; c < CHAR_COUNT; c++)
+		{
+			if (window[c] == 0)
+				continue;
+			block[c] += window[c];
+			weights[c] = merged[c];
+		}
+	}
+	HUFFMAN_STATS_STOP(kHuffmanStageHistogram, start);
+	/* Une fin plus courte qu'une fenêtre reste dans le bloc. */
+	return size - pos < step ? size : pos;
+}
+
+static double weight(uint64_t count)
+{
+	return count > 0 ? (double)count * log2((double)count) : 0;
+}
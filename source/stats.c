@@ -0,0 +1,86 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "huffman/stats.h"
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HUFFMAN_STATS
+_Thread_local huffman_stats_t *huffman_stats_current = NULL;
+
+uint64_t huffman_stats_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+static const char *const stage_names[kHuffmanStageCount] = {"histogram", "sort",  "build",  "code",
+                                                             "write",     "table", "decode", "checksum"};
+
+/*
+ * Remet stats à zéro et en fait les compteurs de ce thread (stats peut être NULL). Renvoie les compteurs précédents,
+ * à rendre à huffman_stats_end(). Sans HUFFMAN_STATS, seuls les totaux d'une compression y sont ensuite écrits.
+ */
+huffman_stats_t *huffman_stats_begin(huffman_stats_t *stats)
+{
+	if (stats != NULL)
+		memset(stats, 0, sizeof(huffman_stats_t));
+#ifdef HUFFMAN_STATS
+	huffman_stats_t *previous = huffman_stats_current;
+	huffman_stats_current = stats;
+	return previous;
+#else
+	return NULL;
+#endif
+}
+
+void huffman_stats_end(huffman_stats_t *previous)
+{
+#ifdef HUFFMAN_STATS
+	huffman_stats_current = previous;
+#else
+	(void)previous;
+#endif
+}
+
+void huffman_stats_merge(huffman_stats_t *stats, const huffman_stats_t *other)
+{
+	for (int stage = 0; stage < kHuffmanStageCount; stage++)
+		stats->time[stage] += other->time[stage];
+	stats->bytes_in += other->bytes_in;
+	stats->bytes_out += other->bytes_out;
+	stats->blocks += other->blocks;
+	stats->bits += other->bits;
+	stats->symbols = other->symbols > stats->symbols ? other->symbols : stats->symbols;
+	stats->max_code_length =
+		other->max_code_length > stats->max_code_length ? other->max_code_length : stats->max_code_length;
+	stats->allocations += other->allocations;
+	stats->allocated += other->allocated;
+}
+
+const char *huffman_stats_stage_name(huffman_stage_t stage)
+{
+	return stage_names[stage];
+}
+
+/*
+ * Écrit stats sur une ligne au format JSON.
+ */
+void huffman_stats_dump(const huffman_stats_t *stats, FILE *file)
+{
+#ifdef HUFFMAN_STATS
+	fprintf(file, "{\"enabled\": true, \"time_ns\": {");
+#else
+	fprintf(file, "{\"enabled\": false, \"time_ns\": {");
+#endif
+	for (int stage = 0; stage < kHuffmanStageCount; stage++)
+		fprintf(file, "%s\"%s\": %" PRIu64, stage == 0 ? "" : ", ", stage_names[stage], stats->time[stage]);
+	fprintf(file,
+	        "}, \"bytes_in\": %" PRIu64 ", \"bytes_out\": %" PRIu64 ", \"blocks\": %" PRIu64 ", \"bits\": %" PRIu64
+	        ", \"symbols\": %u, \"max_code_length\": %u, \"allocations\": %" PRIu64 ", \"allocated\": %" PRIu64
+	        "}\n",
+	        stats->bytes_in, stats->bytes_out, stats->blocks, stats->bits, stats->symbols, stats->max_code_length,
+	        stats->allocations, stats->allocated);
+}
@@ -0,0 +1,484 @@
+#include "huffman/stream.h"
+#include "huffman/decode.h"
+#include "huffman/error.h"
+#include "huffman/format.h"
+#include "huffman/header.h"
+#include "huffman/limits.h"
+#include "huffman/reader.h"
+#include "huffman/stats.h"
+#include <string.h>
+
+/*
+ * Nombre maximal d'octets de l'ancien format décodés à la fois.
+ */
+#define STREAM_BITS_CHUNK (1 << 16)
+
+static void expect(huffman_stream_t *stream, huffman_stream_stage_t stage, size_t expected);
+static bool ready(const huffman_stream_t *stream);
+static bool reserve(huffman_stream_t *stream, size_t size);
+static bool allocate_output(huffman_stream_t *stream, uint32_t block_size);
+static huffman_status_t advance(huffman_stream_t *stream);
+static huffman_status_t read_header(huffman_stream_t *stream);
+static huffman_status_t read_block(huffman_stream_t *stream);
+static huffman_status_t decode_block(huffman_stream_t *stream);
+static huffman_status_t read_trailer(huffman_stream_t *stream);
+static huffman_status_t read_tree(huffman_stream_t *stream);
+static huffman_status_t decode_bits(huffman_stream_t *stream);
+static size_t bits_expected(const huffman_stream_t *stream);
+static uint8_t tree_depth(const huffman_tree_t *tree, uint16_t node);
+
+/*
+ * options peut être NULL (options par défaut) ; toute la mémoire vient de options->allocator. Les blocs sont décodés
+ * un par un, options->threads est ignoré.
+ */
+huffman_stream_t *huffman_stream_new(const huffman_options_t *options)
+{
+	huffman_options_t defaults;
+
+	if (options == NULL)
+	{
+		huffman_options_init(&defaults);
+		options = &defaults;
+	}
+	huffman_stream_t *stream = huffman_calloc(options->allocator, 1, sizeof(huffman_stream_t));
+	if (stream == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return NULL;
+	}
+	stream->context = huffman_context_new(options);
+	if (stream->context == NULL)
+	{
+		huffman_free(options->allocator, stream);
+		return NULL;
+	}
+	stream->context->options.threads = 1;
+	/* Le résumé de la trame est la plus longue des étapes qui ne sont pas un bloc. */
+	if (!reserve(stream, HUFFMAN_FRAME_TRAILER_SIZE(HUFFMAN_FORMAT_VERSION)))
+	{
+		huffman_stream_free(stream);
+		return NULL;
+	}
+	huffman_stream_reset(stream);
+	return stream;
+}
+
+/*
+ * Attend le début d'une nouvelle trame, indépendante des précédentes (comme après huffman_context_reset()). Les
+ * caractères décodés qui n'ont pas été lus sont perdus.
+ */
+void huffman_stream_reset(huffman_stream_t *stream)
+{
+	huffman_context_reset(stream->context);
+	stream->status = kHuffmanOk;
+	stream->pos = 0;
+	stream->size = 0;
+	stream->total = 0;
+	stream->blocks = 0;
+	expect(stream, kHuffmanStreamHeader, HUFFMAN_MAGIC_SIZE + 1);
+}
+
+void huffman_stream_free(huffman_stream_t *stream)
+{
+	if (stream == NULL)
+		return;
+	const huffman_allocator_t *allocator = stream->context->options.allocator;
+	huffman_free(allocator, stream->input);
+	huffman_free(allocator, stream->output);
+	huffman_context_free(stream->context);
+	huffman_free(allocator, stream);
+}
+
+/*
+ * Prend au plus src_size octets de src ; *consumed reçoit le nombre d'octets pris. Rien n'est pris tant que les
+ * caractères décodés n'ont pas été lus (tous ceux du dernier bloc, ou assez pour faire de la place avec l'ancien
+ * format), ni après la fin de la trame : ce qui suit (l'index des blocs, une autre trame) reste à l'appelant.
+ */
+huffman_status_t huffman_stream_feed(huffman_stream_t *stream, const uint8_t *src, size_t src_size, size_t *consumed)
+{
+	*consumed = 0;
+	huffman_stats_t *previous = huffman_stats_begin(stream->context->options.stats);
+	while (src_size > 0 && stream->status == kHuffmanOk && ready(stream))
+	{
+		/* L'ancien format décode tout ce qu'il reçoit : sa taille à prendre dépend de la place libre dans output. */
+		if (stream->stage == kHuffmanStreamBits)
+			stream->expected = bits_expected(stream);
+		size_t n = stream->expected - stream->received;
+		if (n > src_size)
+			n = src_size;
+		memcpy(stream->input + stream->received, src, n);
+		stream->received += n;
+		src += n, src_size -= n;
+		*consumed += n;
+		if (stream->received == stream->expected || stream->stage == kHuffmanStreamBits)
+			stream->status = advance(stream);
+	}
+	huffman_stats_end(previous);
+	return stream->status;
+}
+
+/*
+ * Copie dans dst au plus dst_capacity caractères décodés ; *dst_size reçoit leur nombre, nul s'il faut d'abord donner
+ * la suite de la trame à huffman_stream_feed().
+ */
+huffman_status_t huffman_stream_read(huffman_stream_t *stream, uint8_t *dst, size_t dst_capacity, size_t *dst_size)
+{
+	size_t n = stream->size - stream->pos;
+	if (n > dst_capacity)
+		n = dst_capacity;
+	if (n > 0)
+		memcpy(dst, stream->output + stream->pos, n);
+	stream->pos += n;
+	if (stream->pos == stream->size)
+		stream->pos = stream->size = 0;
+	*dst_size = n;
+	return stream->status;
+}
+
+/*
+ * Vrai une fois la trame entière reçue, vérifiée et lue.
+ */
+bool huffman_stream_finished(const huffman_stream_t *stream)
+{
+	return stream->status == kHuffmanOk && stream->stage == kHuffmanStreamEnd && stream->pos == stream->size;
+}
+
+static void expect(huffman_stream_t *stream, huffman_stream_stage_t stage, size_t expected)
+{
+	stream->stage = stage;
+	stream->received = 0;
+	stream->expected = expected;
+}
+
+/*
+ * Vrai si le flux peut prendre des octets : pour l'ancien format, s'il y a de la place pour les caractères d'un octet
+ * de plus (bits_expected()).
+ */
+static bool ready(const huffman_stream_t *stream)
+{
+	if (stream->stage == kHuffmanStreamEnd)
+		return false;
+	if (stream->stage == kHuffmanStreamBits)
+		return bits_expected(stream) > stream->received;
+	return stream->pos == stream->size;
+}
+
+/*
+ * Agrandit input à au moins size octets, en gardant les octets déjà reçus.
+ */
+static bool reserve(huffman_stream_t *stream, size_t size)
+{
+	const huffman_allocator_t *allocator = stream->context->options.allocator;
+
+	if (size <= stream->capacity)
+		return true;
+	uint8_t *input = huffman_alloc(allocator, size);
+	if (input == NULL)
+	{
+		huffman_error_set("Allocation mémoire dynamique.");
+		return false;
+	}
+	if (stream->received > 0)
+		memcpy(input, stream->input, stream->received);
+	huffman_free(allocator, stream->input);
+	stream->input = input;
+	stream->capacity = size;
+	return true;
+}
+
+static bool allocate_output(huffman_stream_t *stream, uint32_t block_size)
+{
+	const huffman_allocator_t *allocator = stream->context->options.allocator;
+
+	if (stream->output == NULL || block_size != stream->block_size)
+	{
+		huffman_free(allocator, stream->output);
+		if ((stream->output = huffman_alloc(allocator, block_size)) == NULL)
+		{
+			huffman_error_set("Allocation mémoire dynamique.");
+			return false;
+		}
+	}
+	stream->block_size = block_size;
+	return true;
+}
+
+/*
+ * Appelée lorsque les expected octets de l'étape en cours ont été reçus.
+ */
+static huffman_status_t advance(huffman_stream_t *stream)
+{
+	if (stream->stage == kHuffmanStreamHeader)
+		return read_header(stream);
+	if (stream->stage == kHuffmanStreamBlock)
+		return read_block(stream);
+	if (stream->stage == kHuffmanStreamData)
+		return decode_block(stream);
+	if (stream->stage == kHuffmanStreamTrailer)
+		return read_trailer(stream);
+	if (stream->stage == kHuffmanStreamTree)
+		return read_tree(stream);
+	return decode_bits(stream);
+}
+
+/*
+ * Les cinq premiers octets distinguent les deux formats, comme pour huffman_decompress() : l'ancien format commence
+ * par la taille du fichier sur 4 octets, suivie de l'entête d'arbre. Pour le format par blocs, l'entête de la trame
+ * est vérifiée, et le tampon des caractères décodés alloué pour sa taille de bloc.
+ */
+static huffman_status_t read_header(huffman_stream_t *stream)
+{
+	uint8_t version = stream->input[HUFFMAN_MAGIC_SIZE];
+	bool frame =
+		memcmp(stream->input, HUFFMAN_MAGIC, HUFFMAN_MAGIC_SIZE) == 0 && version >= HUFFMAN_FORMAT_VERSION_MIN;
+
+	if (stream->received == HUFFMAN_MAGIC_SIZE + 1)
+	{
+		if (frame)
+		{
+			stream->expected = HUFFMAN_FRAME_HEADER_SIZE;
+			return kHuffmanOk;
+		}
+		stream->remaining = huffman_load_be32(stream->input);
+		stream->stage = kHuffmanStreamTree;
+		stream->expected = 4 + 2;
+		return kHuffmanOk;
+	}
+	uint32_t block_size = huffman_load_be32(stream->input + HUFFMAN_MAGIC_SIZE + 1);
+	if (version > HUFFMAN_FORMAT_VERSION)
+	{
+		huffman_error_set("Version du format non supportée (%d).", version);
+		return kHuffmanErrorData;
+	}
+	if (block_size == 0 || block_size > HUFFMAN_BLOCK_SIZE_MAX)
+	{
+		huffman_error_set("Taille de bloc invalide (%u).", block_size);
+		return kHuffmanErrorData;
+	}
+	if (!allocate_output(stream, block_size))
+		return kHuffmanErrorMemory;
+	stream->version = version;
+	expect(stream, kHuffmanStreamBlock, 1);
+	return kHuffmanOk;
+}
+
+/*
+ * Le type d'un bloc est lu seul : le bloc de fin n'a pas d'autre entête. Pour les autres blocs, l'entête donne la
+ * taille du reste du bloc, qui est reçu à la suite de l'entête dans input.
+ */
+static huffman_status_t read_block(huffman_stream_t *stream)
+{
+	const uint8_t *input = stream->input;
+
+	if (stream->received == 1)
+	{
+		if (input[0] != kHuffmanBlockEnd)
+		{
+			stream->expected = HUFFMAN_BLOCK_HEADER_SIZE;
+			return kHuffmanOk;
+		}
+		HUFFMAN_STATS_ADD(bytes_in, HUFFMAN_FRAME_HEADER_SIZE + 1);
+		if (stream->version < 3)
+			stream->stage = kHuffmanStreamEnd;
+		else
+			expect(stream, kHuffmanStreamTrailer, HUFFMAN_FRAME_TRAILER_SIZE(stream->version));
+		return kHuffmanOk;
+	}
+	if ((input[0] & ~(HUFFMAN_BLOCK_INTERLEAVED | HUFFMAN_BLOCK_CHECKSUM)) > kHuffmanBlockRun)
+	{
+		huffman_error_set("Type de bloc inconnu (%d).", input[0]);
+		return kHuffmanErrorData;
+	}
+	uint32_t size = huffman_load_be32(input + 1);
+	uint32_t length = huffman_load_be32(input + 5);
+	if (size == 0 || size > stream->block_size || length > HUFFMAN_BLOCK_LENGTH_MAX(size))
+	{
+		huffman_error_set("Taille de bloc invalide (%u).", size);
+		return kHuffmanErrorData;
+	}
+	if (!reserve(stream, HUFFMAN_BLOCK_HEADER_SIZE + (size_t)length))
+		return kHuffmanErrorMemory;
+	stream->stage = kHuffmanStreamData;
+	stream->expected = HUFFMAN_BLOCK_HEADER_SIZE + (size_t)length;
+	return stream->received == stream->expected ? decode_block(stream) : kHuffmanOk;
+}
+
+static huffman_status_t decode_block(huffman_stream_t *stream)
+{
+	huffman_status_t status = huffman_context_decompress_block(stream->context, stream->block_size, stream->input,
+	                                                           stream->received, stream->output, stream->block_size,
+	                                                           &stream->size);
+	if (status != kHuffmanOk)
+		return status;
+	stream->pos = 0;
+	stream->total += stream->size;
+	stream->blocks++;
+	expect(stream, kHuffmanStreamBlock, 1);
+	return kHuffmanOk;
+}
+
+/*
+ * Le résumé doit donner le nombre de caractères et de blocs décodés et, depuis la version 10, le CRC-32C de ces
+ * caractères, que huffman_context_decompress_block() ajoute bloc par bloc à celui de la trame du contexte.
+ */
+static huffman_status_t read_trailer(huffman_stream_t *stream)
+{
+	HUFFMAN_STATS_ADD(bytes_in, HUFFMAN_FRAME_TRAILER_SIZE(stream->version));
+	if (huffman_load_be64(stream->input) != stream->total || huffman_load_be64(stream->input + 8) != stream->blocks)
+	{
+		huffman_error_set("Taille totale incohérente.");
+		return kHuffmanErrorData;
+	}
+	if (stream->version >= HUFFMAN_FORMAT_VERSION_CHECKSUM && huffman_load_be32(stream->input + 16) != stream->context->decoder.checksum)
+	{
+		huffman_error_set("Somme de contrôle de la trame invalide.");
+		return kHuffmanErrorData;
+	}
+	stream->stage = kHuffmanStreamEnd;
+	return kHuffmanOk;
+}
+
+/*
+ * Entête d'arbre de l'ancien format, après la taille du fichier : sa taille se déduit du nombre de feuilles, donné par
+ * ses deux premiers octets (huffman_read_header()).
+ */
+static huffman_status_t read_tree(huffman_stream_t *stream)
+{
+	huffman_state_t *state = &stream->context->state;
+	huffman_reader_t reader;
+
+	if (stream->received == 4 + 2)
+	{
+		uint16_t leaves = stream->input[4] + stream->input[5];
+		if (leaves == 0 || leaves > CHAR_COUNT)
+		{
+			huffman_error_set("Nombre de feuilles invalide (%d).", leaves);
+			return kHuffmanErrorData;
+		}
+		stream->expected = 4 + 2 + leaves + (2 * leaves - 1 + 7) / 8;
+		return reserve(stream, stream->expected) ? kHuffmanOk : kHuffmanErrorMemory;
+	}
+	huffman_reader_init_memory(&reader, stream->input + 4, stream->received - 4);
+	if (!huffman_read_header(&reader, state))
+		return kHuffmanErrorData;
+	if (!allocate_output(stream, HUFFMAN_BLOCK_SIZE_DEFAULT) || !reserve(stream, STREAM_BITS_CHUNK))
+		return kHuffmanErrorMemory;
+	huffman_decode_table_build(&stream->context->table, &state->tree);
+	stream->depth = tree_depth(&state->tree, state->tree.root);
+	stream->offset = 0;
+	HUFFMAN_STATS_ADD(blocks, 1);
+	HUFFMAN_STATS_ADD(bytes_in, stream->received);
+	HUFFMAN_STATS_ADD(bytes_out, stream->remaining);
+	stream->node = state->tree.root;
+	if (stream->remaining == 0)
+		stream->stage = kHuffmanStreamEnd;
+	else
+		expect(stream, kHuffmanStreamBits, 0);
+	return kHuffmanOk;
+}
+
+/*
+ * Décode les octets reçus. Tant qu'il reste au moins stream->depth bits, huffman_decode() prend autant de caractères
+ * que ces bits en contiennent sûrement. Ensuite, un codage n'est pris dans la table que s'il tient dans les bits reçus
+ * (les zéros lus au-delà ne changent pas un préfixe complet) ; sinon ses bits sont gardés pour les octets suivants.
+ * Un codage plus long que la table parcourt l'arbre, et le parcours reprend au même noeud avec les octets suivants.
+ */
+static huffman_status_t decode_bits(huffman_stream_t *stream)
+{
+	const huffman_tree_t *tree = &stream->context->state.tree;
+	const huffman_decode_entry_t *entries = stream->context->table.entries;
+	uint64_t left = (uint64_t)stream->received * 8 - stream->offset;
+	huffman_reader_t reader;
+
+	huffman_reader_init_memory(&reader, stream->input, stream->received);
+	huffman_reader_refill(&reader);
+	huffman_reader_consume(&reader, stream->offset);
+	while (left > 0 && stream->remaining > 0)
+	{
+		uint64_t count = stream->node == tree->root ? left / stream->depth : 0;
+		if (count > stream->remaining)
+			count = stream->remaining;
+		if (count > 0)
+		{
+			uint64_t start = huffman_reader_tell(&reader);
+			huffman_decode(&reader, &stream->context->table, tree, stream->output + stream->size, count);
+			left -= huffman_reader_tell(&reader) - start;
+			stream->size += count;
+			stream->remaining -= count;
+			continue;
+		}
+		huffman_reader_refill(&reader);
+		if (stream->node == tree->root)
+		{
+			huffman_decode_entry_t entry = entries[reader.bits >> (64 - HUFFMAN_DECODE_ROOT_BITS)];
+			uint8_t length = entry.length;
+			if (entry.type != kHuffmanEntrySymbol)
+			{
+				entry = entries[entry.value + (reader.bits << HUFFMAN_DECODE_ROOT_BITS >> (64 - entry.length))];
+				length = HUFFMAN_DECODE_ROOT_BITS + entry.length;
+			}
+			if (length > left)
+				break;
+			huffman_reader_consume(&reader, length);
+			left -= length;
+			if (entry.type == kHuffmanEntryNode)
+			{
+				stream->node = entry.value;
+				continue;
+			}
+			stream->output[stream->size++] = entry.value;
+			stream->remaining--;
+			continue;
+		}
+		const huffman_node_t *node = &tree->nodes[stream->node];
+		stream->node = reader.bits >> 63 ? node->u.node.right_child : node->u.node.left_child;
+		huffman_reader_consume(&reader, 1);
+		left--;
+		if (tree->nodes[stream->node].type == kHuffmanNodeLeaf)
+		{
+			stream->output[stream->size++] = tree->nodes[stream->node].u.leaf.c;
+			stream->node = tree->root;
+			stream->remaining--;
+		}
+	}
+	if (stream->remaining == 0)
+	{
+		HUFFMAN_STATS_ADD(bytes_in, stream->received);
+		stream->stage = kHuffmanStreamEnd;
+		return kHuffmanOk;
+	}
+	/* Les bits restants, moins d'un codage, passent au début de input. */
+	uint64_t used = (uint64_t)stream->received * 8 - left;
+	HUFFMAN_STATS_ADD(bytes_in, used / 8);
+	memmove(stream->input, stream->input + used / 8, stream->received - used / 8);
+	stream->received -= used / 8;
+	stream->offset = used % 8;
+	return kHuffmanOk;
+}
+
+/*
+ * Taille de input à atteindre pour l'ancien format. Chaque caractère qui reste à décoder occupe au moins un bit au-delà
+ * des bits gardés, qui ne forment pas un codage complet : ces octets font donc partie de la trame. Chaque bit reçu
+ * donne au plus un caractère, qui doit tenir dans output.
+ */
+static size_t bits_expected(const huffman_stream_t *stream)
+{
+	uint64_t n = stream->received + (stream->remaining + 7) / 8;
+	size_t room = (stream->block_size - stream->size + stream->offset) / 8;
+	if (n > room)
+		n = room;
+	return n < stream->capacity ? n : stream->capacity;
+}
+
+/*
+ * Profondeur du sous-arbre de node, au moins 1 : une seule feuille est codée sur un bit.
+ */
+static uint8_t tree_depth(const huffman_tree_t *tree, uint16_t node)
+{
+	const huffman_node_t *current = &tree->nodes[node];
+	if (current->type == kHuffmanNodeLeaf)
+		return node == tree->root;
+	uint8_t left = tree_depth(tree, current->u.node.left_child);
+	uint8_t right = tree_depth(tree, current->u.node.right_child);
+	return 1 + (left > right ? left : right);
+}
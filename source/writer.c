@@ -0,0 +1,114 @@
+#include "huffman/writer.h"
+#include <string.h>
+
+void huffman_writer_init(huffman_writer_t *writer, uint8_t *data, size_t capacity, FILE *wfd)
+{
+	writer->data = data;
+	writer->size = 0;
+	writer->capacity = capacity;
+	writer->wfd = wfd;
+	writer->sink = NULL;
+	writer->opaque = NULL;
+	writer->acc = 0;
+	writer->count = 0;
+	writer->failed = false;
+	writer->written = 0;
+}
+
+/*
+ * Comme huffman_writer_init(), data étant vidé dans sink au lieu d'un fichier.
+ */
+void huffman_writer_init_sink(huffman_writer_t *writer, uint8_t *data, size_t capacity, huffman_sink_t sink,
+                              void *opaque)
+{
+	huffman_writer_init(writer, data, capacity, NULL);
+	writer->sink = sink;
+	writer->opaque = opaque;
+}
+
+void huffman_writer_word(huffman_writer_t *writer, uint64_t word)
+{
+	if (writer->capacity - writer->size < 8 && !huffman_writer_flush(writer))
+		return;
+	uint8_t *p = writer->data + writer->size;
+	p[0] = word >> 56, p[1] = word >> 48, p[2] = word >> 40, p[3] = word >> 32;
+	p[4] = word >> 24, p[5] = word >> 16, p[6] = word >> 8, p[7] = word;
+	writer->size += 8;
+}
+
+void huffman_writer_align(huffman_writer_t *writer)
+{
+	if (writer->count % 8 != 0)
+		huffman_writer_put(writer, 0, 8 - writer->count % 8);
+}
+
+/*
+ * Position en bits dans la sortie du prochain bit à écrire.
+ */
+uint64_t huffman_writer_tell(const huffman_writer_t *writer)
+{
+	return (writer->written + writer->size) * 8 + writer->count;
+}
+
+/*
+ * Copie size octets à partir d'une position alignée sur l'octet : les bits en attente sont complétés octet par
+ * octet, puis le reste est copié directement dans data.
+ */
+void huffman_writer_bytes(huffman_writer_t *writer, const uint8_t *data, size_t size)
+{
+	for (; size > 0 && writer->count > 0; size--)
+		huffman_writer_put(writer, *data++, 8);
+	while (size > 0)
+	{
+		if (writer->size == writer->capacity && !huffman_writer_flush(writer))
+			return;
+		size_t n = writer->capacity - writer->size;
+		if (size < n)
+			n = size;
+		memcpy(writer->data + writer->size, data, n);
+		writer->size += n;
+		data += n, size -= n;
+	}
+}
+
+/*
+ * Complète le dernier octet avec des zéros et vide le tampon dans le fichier ou sink. Sinon, les octets restent dans
+ * data.
+ */
+bool huffman_writer_finish(huffman_writer_t *writer)
+{
+	huffman_writer_align(writer);
+	if (writer->capacity - writer->size < (size_t)writer->count / 8 && !huffman_writer_flush(writer))
+		return false;
+	for (uint8_t shift = 56; writer->count > 0; shift -= 8, writer->count -= 8)
+		writer->data[writer->size++] = writer->acc >> shift;
+	writer->acc = 0;
+	if (writer->wfd != NULL || writer->sink != NULL)
+		huffman_writer_flush(writer);
+	return !writer->failed;
+}
+
+/*
+ * Vide data dans sink ou dans le fichier. Sans l'un ni l'autre, data est plein : l'écriture échoue.
+ */
+bool huffman_writer_flush(huffman_writer_t *writer)
+{
+	if (writer->sink != NULL)
+	{
+		if (writer->size > 0 && !writer->sink(writer->opaque, writer->data, writer->size))
+			writer->failed = true;
+	}
+	else if (writer->wfd == NULL || fwrite(writer->data, 1, writer->size, writer->wfd) != writer->size)
+		writer->failed = true;
+	else
+		writer->written += writer->size;
+	writer->size = 0;
+	return !writer->failed;
+}
+
+const char *huffman_writer_error(const huffman_writer_t *writer)
+{
+	if (writer->sink != NULL)
+		return "Lors de l'écriture.";
+	return writer->wfd != NULL ? "Lors de l'écriture (fwrite)." : "Tampon de sortie trop petit.";
+}